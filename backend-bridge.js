@@ -151,74 +151,284 @@ function writeVendorToDat(vendor) {
 }
 
 // ======================= FILE READING FUNCTIONS =======================
-function readAllFromDat(filename, parseFunc, size) {
+// .dat files are read a fixed-size chunk at a time, never whole
+const READ_CHUNK_BYTES = 1 << 20;
+
+// Call visit(record) for each record of a .dat file until it returns true; returns that record
+function forEachInDat(filename, parseFunc, size, visit) {
     const filepath = path.join(DATA_DIR, filename);
-    const results = [];
-    
     if (!fs.existsSync(filepath)) {
-        return results;
+        return null;
     }
-    
+
+    let fd = null;
     try {
-        const data = fs.readFileSync(filepath);
-        for (let i = 0; i < data.length; i += size) {
-            if (i + size <= data.length) {
-                results.push(parseFunc(data.slice(i, i + size)));
+        fd = fs.openSync(filepath, 'r');
+        const buffer = Buffer.alloc(Math.max(1, Math.floor(READ_CHUNK_BYTES / size)) * size);
+        let position = 0;
+        for (;;) {
+            const bytesRead = fs.readSync(fd, buffer, 0, buffer.length, position);
+            const whole = bytesRead - (bytesRead % size);  // a trailing partial record is ignored
+            for (let i = 0; i < whole; i += size) {
+                const record = parseFunc(buffer.slice(i, i + size));
+                if (visit(record)) {
+                    return record;
+                }
             }
+            if (bytesRead < buffer.length) {
+                return null;
+            }
+            position += bytesRead;
         }
     } catch (error) {
         console.error(`Error reading ${filename}:`, error);
+        return null;
+    } finally {
+        if (fd !== null) fs.closeSync(fd);
     }
-    
-    return results;
 }
 
-function findById(filename, parseFunc, size, id) {
-    const filepath = path.join(DATA_DIR, filename);
-    
+// ======================= SHARDED STORAGE =======================
+// After backend op 24 (migrate to shards) registrations, staff and vendors live in
+// per-event files like registrations_e500.dat, listed in shards.manifest
+const SHARD_MANIFEST = 'shards.manifest';
+
+function shardFileName(filename, eventID) {
+    return filename.replace(/\.dat$/, '') + '_e' + eventID + '.dat';
+}
+
+function readShardManifest() {
+    const filepath = path.join(DATA_DIR, SHARD_MANIFEST);
     if (!fs.existsSync(filepath)) {
         return null;
     }
-    
-    try {
-        const data = fs.readFileSync(filepath);
-        for (let i = 0; i < data.length; i += size) {
-            if (i + size <= data.length) {
-                const obj = parseFunc(data.slice(i, i + size));
-                if (obj.ID === id) {
-                    return obj;
-                }
-            }
-        }
-    } catch (error) {
-        console.error(`Error reading ${filename}:`, error);
+    const lines = fs.readFileSync(filepath, 'utf8').split('\n').slice(1);
+    return lines
+        .map(line => line.trim().split(/\s+/))
+        .filter(parts => parts.length === 2)
+        .map(parts => ({ filename: parts[0], eventID: parseInt(parts[1]) }));
+}
+
+// Visit every record of a table, whether it is one global file or a set of per-event shards
+function forEachInTable(filename, parseFunc, size, visit) {
+    const shards = readShardManifest();
+    if (!shards) {
+        forEachInDat(filename, parseFunc, size, visit);
+        return;
     }
-    
-    return null;
+    shards
+        .filter(shard => shard.filename === filename)
+        .forEach(shard => forEachInDat(shardFileName(filename, shard.eventID), parseFunc, size, visit));
+}
+
+function findById(filename, parseFunc, size, id) {
+    return forEachInDat(filename, parseFunc, size, obj => obj.ID === id);
 }
 
 function findByUsername(filename, parseFunc, size, username) {
-    const filepath = path.join(DATA_DIR, filename);
-    
-    if (!fs.existsSync(filepath)) {
+    return forEachInDat(filename, parseFunc, size, obj => obj.username === username);
+}
+
+// ======================= BACKEND OUTPUT PARSING =======================
+// Line formats printed by the staff, vendor and registration list ops (also used in change feed lines)
+function parseStaffLine(line, eventID) {
+    const idMatch = line.match(/ID:\s*(\d+)/);
+    const nameMatch = line.match(/Name:\s*(.+?)(?:\s+Email:|$)/);
+    const emailMatch = line.match(/Email:\s*(.+?)(?:\s+Team:|$)/);
+    const teamMatch = line.match(/Team:\s*(.+?)(?:\s+Position:|$)/);
+    const positionMatch = line.match(/Position:\s*(.+?)(?:\s*$)/);
+
+    if (!idMatch) {
         return null;
     }
-    
-    try {
-        const data = fs.readFileSync(filepath);
-        for (let i = 0; i < data.length; i += size) {
-            if (i + size <= data.length) {
-                const obj = parseFunc(data.slice(i, i + size));
-                if (obj.username === username) {
-                    return obj;
+    return {
+        ID: parseInt(idMatch[1]),
+        name: nameMatch ? nameMatch[1].trim() : 'Unknown',
+        email: emailMatch ? emailMatch[1].trim() : 'N/A',
+        team: teamMatch ? teamMatch[1].trim() : 'N/A',
+        position: positionMatch ? positionMatch[1].trim() : 'N/A',
+        eventID: eventID
+    };
+}
+
+function parseVendorLine(line, eventID) {
+    const idMatch = line.match(/ID:\s*(\d+)/);
+    const nameMatch = line.match(/Name:\s*(.+?)(?:\s+Email:|$)/);
+    const emailMatch = line.match(/Email:\s*(.+?)(?:\s+Product\/Service:|$)/);
+    const prodMatch = line.match(/Product\/Service:\s*(.+?)(?:\s+Charges:|$)/);
+    const chargesMatch = line.match(/Charges:\s*(\d+)/);
+
+    if (!idMatch) {
+        return null;
+    }
+    return {
+        ID: parseInt(idMatch[1]),
+        name: nameMatch ? nameMatch[1].trim() : 'Unknown',
+        email: emailMatch ? emailMatch[1].trim() : 'N/A',
+        prod_serv: prodMatch ? prodMatch[1].trim() : 'N/A',
+        chargesDue: chargesMatch ? parseInt(chargesMatch[1]) : 0,
+        eventID: eventID
+    };
+}
+
+function parseRegistrationLine(line) {
+    const custIdMatch = line.match(/CustID:\s*(\d+)/);
+    const nameMatch = line.match(/Name:\s*([^\s]+(?:\s+[^\s]+)?)\s+Email:/);
+    const emailMatch = line.match(/Email:\s*(\S+)/);
+    const ticketMatch = line.match(/Ticket:\s*(\d+)/);
+    const statusMatch = line.match(/Status:\s*(\w+)/);
+
+    if (!custIdMatch) {
+        return null;
+    }
+    return {
+        customerID: parseInt(custIdMatch[1]),
+        customerName: nameMatch ? nameMatch[1] : 'Unknown',
+        customerEmail: emailMatch ? emailMatch[1] : 'unknown@email.com',
+        ticketNum: ticketMatch ? parseInt(ticketMatch[1]) : 0,
+        feeStatus: statusMatch ? statusMatch[1] : 'Unpaid'
+    };
+}
+
+// "Change: 12 Table: staff Type: update EventID: 500 <record line>" from ops 25/26 and pushes
+function parseChangeLine(line) {
+    const match = line.match(/^Change:\s*(\d+)\s+Table:\s*(\w+)\s+Type:\s*(\w+)\s+EventID:\s*(-?\d+)\s+(.*)$/);
+    if (!match) {
+        return null;
+    }
+    const eventID = parseInt(match[4]);
+    let record = null;
+    if (match[2] === 'staff') {
+        record = parseStaffLine(match[5], eventID);
+    } else if (match[2] === 'vendors') {
+        record = parseVendorLine(match[5], eventID);
+    } else if (match[2] === 'registrations') {
+        record = parseRegistrationLine(match[5]);
+        if (record) {
+            // Change lines carry no customer details; fill them in from customers.dat
+            const customer = findById('customers.dat', parseCustomer, CUSTOMER_SIZE, record.customerID);
+            record.customerName = customer ? customer.name : 'Unknown';
+            record.customerEmail = customer ? customer.email : 'unknown@email.com';
+        }
+    }
+    return { seq: parseInt(match[1]), table: match[2], type: match[3], eventID, record };
+}
+
+// Apply one parsed change to a cached list (idempotent: inserts and updates upsert, deletes remove)
+function applyChangeToView(view, change) {
+    const sameRecord = change.table === 'registrations'
+        ? (r => r.customerID === change.record.customerID)
+        : (r => r.ID === change.record.ID);
+    const index = view.findIndex(sameRecord);
+    if (change.type === 'delete') {
+        if (index !== -1) view.splice(index, 1);
+    } else if (index !== -1) {
+        view[index] = change.record;
+    } else {
+        view.push(change.record);
+    }
+}
+
+// ======================= RESIDENT BACKEND =======================
+// One long-lived "backend --serve" process instead of a spawn per request.
+// Requests are a line with the byte length of the usual input lines, then those lines, so a
+// field can't end a request early; responses end with an "END" line.
+// "Change:" lines (pushes, or a subscription's backlog) are applied as soon as they are read,
+// so a mutation's own change is already in the cached views when its response resolves.
+// A request made with an onLine callback gets its lines one at a time instead of buffered.
+// A request's timeout starts when the server reaches it, not while it waits behind others.
+const RESIDENT_TIMEOUT_MS = 15000;
+
+class ResidentBackend {
+    constructor(onPush) {
+        this.onPush = onPush;
+        this.pending = [];
+        this.lines = [];
+        this.partial = '';
+        this.alive = true;
+        this.failedToStart = false;
+
+        this.child = spawn(BACKEND_EXE, ['--serve'], {
+            cwd: DATA_DIR,
+            stdio: ['pipe', 'pipe', 'pipe']
+        });
+
+        this.child.stdin.on('error', () => {});  // reported through 'error'/'close' below
+        this.child.stdout.on('data', (data) => this.handleOutput(data.toString()));
+        this.child.stderr.on('data', () => {});  // drain debug output so the pipe never fills
+        this.child.on('error', () => {
+            this.failedToStart = true;
+            this.shutdown(new Error('Resident backend failed to start'));
+        });
+        this.child.on('close', () => this.shutdown(new Error('Resident backend exited')));
+    }
+
+    handleOutput(text) {
+        const parts = (this.partial + text).split('\n');
+        this.partial = parts.pop();
+        parts.forEach(line => {
+            if (line === 'END') {
+                const request = this.pending.shift();
+                const output = this.lines.join('\n') + '\n';
+                this.lines = [];
+                if (request) {
+                    clearTimeout(request.timer);
+                    if (!request.abandoned) request.resolve(output);
                 }
+                this.startTimer();
+            } else if (line.startsWith('Change: ') || line.startsWith('Changes Compacted:')) {
+                this.onPush([line]);
+            } else if (line !== 'END PUSH') {
+                const current = this.pending[0];
+                if (current && current.abandoned) {
+                    return;  // already timed out: nobody is waiting for this output
+                }
+                if (current && current.onLine) {
+                    current.onLine(line);
+                } else {
+                    this.lines.push(line);
+                }
+            }
+        });
+    }
+
+    request(inputs, onLine) {
+        return new Promise((resolve, reject) => {
+            if (!this.alive) {
+                reject(new Error('Resident backend not running'));
+                return;
             }
+            const request = { resolve, reject, onLine, timer: null, abandoned: false };
+            this.pending.push(request);
+            this.startTimer();
+            const body = inputs.join('\n') + '\n';
+            this.child.stdin.write(Buffer.byteLength(body) + '\n' + body);
+        });
+    }
+
+    // Time the request at the head of the queue. When it runs out, only that request fails; its
+    // output is dropped when it arrives. A server still stuck on it after a second timeout is
+    // stopped, and the bridge starts a new one for the next request.
+    startTimer() {
+        const request = this.pending[0];
+        if (!request || request.timer) {
+            return;
         }
-    } catch (error) {
-        console.error(`Error reading ${filename}:`, error);
+        request.timer = setTimeout(() => {
+            request.abandoned = true;
+            request.reject(new Error('Backend timeout'));
+            request.timer = setTimeout(() => this.child.kill(), RESIDENT_TIMEOUT_MS);
+        }, RESIDENT_TIMEOUT_MS);
+    }
+
+    shutdown(error) {
+        this.alive = false;
+        this.pending.forEach(request => {
+            clearTimeout(request.timer);
+            if (!request.abandoned) request.reject(error);
+        });
+        this.pending = [];
     }
-    
-    return null;
 }
 
 // Standalone executeCommand for use outside class
@@ -230,15 +440,12 @@ function executeCommandSync(inputs) {
         });
 
         let stdout = '';
-        let stderr = '';
 
         child.stdout.on('data', (data) => {
             stdout += data.toString();
         });
 
-        child.stderr.on('data', (data) => {
-            stderr += data.toString();
-        });
+        child.stderr.on('data', () => {});  // drain debug output without keeping it
 
         // Send all inputs with newlines
         const inputString = inputs.join('\n') + '\n';
@@ -258,8 +465,149 @@ function executeCommandSync(inputs) {
 }
 
 class BackendBridge {
+    constructor() {
+        this.resident = null;
+        this.residentFailed = false;
+        this.subscribed = false;
+        // Cached staff/vendor/registration lists per event, kept current from the change feed
+        this.views = { staff: new Map(), vendors: new Map(), registrations: new Map() };
+        this.lastSeq = null;
+        // Full fetches of a list in flight, with the changes pushed meanwhile (see fetchView)
+        this.viewFetches = new Set();
+    }
+
+    // Send a request to the resident backend, falling back to one spawn per request. With
+    // onLine, output lines are handed over as they arrive and the resolved output is empty,
+    // so a large listing is never held as one string.
+    async executeCommand(inputs, onLine) {
+        // One field per line: a line break inside a value would shift the fields after it
+        if (inputs.some(input => /[\r\n]/.test(String(input)))) {
+            throw new Error('Invalid input: a field cannot contain a line break');
+        }
+        if (this.resident && !this.resident.alive) {
+            this.dropResident(this.resident);
+        }
+        if (!this.resident && !this.residentFailed) {
+            this.resident = new ResidentBackend(lines => this.applyChanges(lines));
+        }
+        const resident = this.resident;
+        if (resident) {
+            try {
+                return await resident.request(inputs, onLine);
+            } catch (error) {
+                if (resident.alive) {
+                    throw error;
+                }
+                this.dropResident(resident);  // and spawn for this request
+            }
+        }
+        return this.spawnCommand(inputs, onLine);
+    }
+
+    // Forget a resident process that died, and its subscription. The next request starts a new
+    // one, unless this one could not start at all.
+    dropResident(resident) {
+        if (this.resident !== resident) {
+            return;
+        }
+        this.residentFailed = resident.failedToStart;
+        this.resident = null;
+        this.subscribed = false;
+    }
+
+    // ======================= CHANGE FEED =======================
+    // Apply "Change:" lines to the cached views (idempotent: inserts and updates upsert, deletes remove)
+    applyChanges(lines) {
+        lines.forEach(line => {
+            if (line.startsWith('Changes Compacted:')) {
+                // Changes since the last sync were dropped from the log: reload views from the files
+                Object.keys(this.views).forEach(table => this.views[table].clear());
+                this.viewFetches.forEach(fetch => { fetch.stale = true; });
+                return;
+            }
+            const change = parseChangeLine(line);
+            if (!change) {
+                return;
+            }
+            this.lastSeq = Math.max(this.lastSeq || 0, change.seq);
+            if (!change.record) {
+                return;
+            }
+            this.viewFetches.forEach(fetch => {
+                if (fetch.table === change.table && Number(fetch.eventID) === change.eventID) {
+                    fetch.changes.push(change);
+                }
+            });
+            const view = this.views[change.table] && this.views[change.table].get(change.eventID);
+            if (view) {
+                applyChangeToView(view, change);
+            }
+        });
+    }
+
+    // Bring cached views up to date: subscribe once in server mode, otherwise poll op 25
+    async syncChanges() {
+        if (this.subscribed) {
+            return;
+        }
+        const since = this.lastSeq === null ? -1 : this.lastSeq;
+        let latest = null;
+        await this.executeCommand([this.resident && this.resident.alive ? '26' : '25', since.toString()], line => {
+            const latestMatch = line.match(/Latest Sequence:\s*(\d+)/);
+            if (latestMatch) {
+                latest = parseInt(latestMatch[1]);
+            } else {
+                this.applyChanges([line]);
+            }
+        });
+        if (latest !== null) {
+            this.lastSeq = latest;
+            this.subscribed = !!(this.resident && this.resident.alive);
+        }
+    }
+
+    // Cached copy of one event's list, or null if it has to be fetched in full
+    async cachedView(table, eventID) {
+        try {
+            await this.syncChanges();
+        } catch (error) {
+            this.views[table].clear();
+            return null;
+        }
+        const view = this.views[table].get(eventID);
+        return view ? view.slice() : null;
+    }
+
+    // Fetch one event's list in full (parseLine returns a record or null per output line) and
+    // cache it. A change pushed while the fetch is in flight may be missing from what the server
+    // read, so changes after the fetch started are replayed onto the result before it is stored.
+    async fetchView(table, eventID, inputs, parseLine) {
+        const fetch = { table, eventID, startSeq: this.lastSeq, changes: [], stale: false };
+        this.viewFetches.add(fetch);
+        try {
+            const records = [];
+            await this.executeCommand(inputs, line => {
+                const record = parseLine(line);
+                if (record) {
+                    records.push(record);
+                }
+            });
+            fetch.changes.forEach(change => {
+                if (fetch.startSeq === null || change.seq > fetch.startSeq) {
+                    applyChangeToView(records, change);
+                }
+            });
+            if (this.lastSeq !== null && !fetch.stale) {
+                this.views[table].set(eventID, records.slice());
+            }
+            return records;
+        } finally {
+            this.viewFetches.delete(fetch);
+        }
+    }
+
     // Execute command by spawning backend process and sending input via stdin
-    executeCommand(inputs) {
+    spawnCommand(inputs, onLine) {
         return new Promise((resolve, reject) => {
             const child = spawn(BACKEND_EXE, [], {
                 cwd: DATA_DIR,
@@ -267,15 +615,19 @@ class BackendBridge {
             });
 
             let stdout = '';
-            let stderr = '';
+            let partial = '';
 
             child.stdout.on('data', (data) => {
-                stdout += data.toString();
+                if (!onLine) {
+                    stdout += data.toString();
+                    return;
+                }
+                const parts = (partial + data.toString()).split('\n');
+                partial = parts.pop();
+                parts.forEach(onLine);
             });
 
-            child.stderr.on('data', (data) => {
-                stderr += data.toString();
-            });
+            child.stderr.on('data', () => {});  // drain debug output without keeping it
 
             // Send all inputs with newlines
             const inputString = inputs.join('\n') + '\n';
@@ -283,6 +635,9 @@ class BackendBridge {
             child.stdin.end();
 
             child.on('close', (code) => {
+                if (onLine && partial) {
+                    onLine(partial);
+                }
                 resolve(stdout);
             });
 
@@ -294,12 +649,26 @@ class BackendBridge {
         });
     }
 
+    // Ask the backend (op 37) whether a username is in use; its Bloom filter usually
+    // answers without reading the whole file
+    async usernameTaken(table, username) {
+        const output = await this.executeCommand([
+            '37',          // OP_CHECK_USERNAME
+            table,
+            username
+        ]);
+        const match = output.match(/Username Taken:\s*(yes|no)/);
+        if (!match) {
+            throw new Error(output.trim() || 'Username check failed');
+        }
+        return match[1] === 'yes';
+    }
+
     // ======================= ORGANISER FUNCTIONS =======================
     async organiserSignup(data) {
         try {
             // Check if username already exists
-            const organisers = readAllFromDat('organisers.dat', parseOrganiser, ORGANISER_SIZE);
-            if (organisers && organisers.some(o => o.username === data.username)) {
+            if (await this.usernameTaken('organisers', data.username)) {
                 return { success: false, message: 'Username already exists' };
             }
 
@@ -318,8 +687,7 @@ class BackendBridge {
             await new Promise(resolve => setTimeout(resolve, 100));
 
             // Read from organisers.dat to get the registered organiser
-            const allOrganisers = readAllFromDat('organisers.dat', parseOrganiser, ORGANISER_SIZE);
-            const newOrganiser = allOrganisers.find(o => o.username === data.username);
+            const newOrganiser = findByUsername('organisers.dat', parseOrganiser, ORGANISER_SIZE, data.username);
 
             if (newOrganiser) {
                 return { 
@@ -387,16 +755,8 @@ class BackendBridge {
             console.log('Starting customer signup for:', data.username);
             
             // Check if username already exists
-            const customers = readAllFromDat('customers.dat', parseCustomer, CUSTOMER_SIZE) || [];
-            console.log('Existing customers:', customers);
             console.log('Checking if username exists:', data.username);
-            
-            const usernameExists = customers.length > 0 && customers.some(c => {
-                console.log('Comparing:', c.username, 'with', data.username, '=', c.username === data.username);
-                return c.username === data.username;
-            });
-            
-            if (usernameExists) {
+            if (await this.usernameTaken('customers', data.username)) {
                 console.log('Username already exists');
                 return { success: false, message: 'Username already exists' };
             }
@@ -418,13 +778,8 @@ class BackendBridge {
             await new Promise(resolve => setTimeout(resolve, 500));
 
             // Read from customers.dat to get the registered customer
-            const allCustomers = readAllFromDat('customers.dat', parseCustomer, CUSTOMER_SIZE) || [];
-            console.log('All customers after signup:', allCustomers);
             console.log('Looking for username:', data.username);
-            const newCustomer = allCustomers.find(c => {
-                console.log('Checking customer:', c.username, 'ID:', c.ID);
-                return c.username === data.username;
-            });
+            const newCustomer = findByUsername('customers.dat', parseCustomer, CUSTOMER_SIZE, data.username);
 
             if (newCustomer) {
                 console.log('Found new customer:', newCustomer);
@@ -490,6 +845,12 @@ class BackendBridge {
             // Generate new event ID (max existing ID + 1, or 1000 if empty)
             const eventId = events.length > 0 ? Math.max(...events.map(e => e.ID)) + 1 : 1000;
             
+            // The backend's seat map assigns seats and ticket numbers for the event
+            const seatOutput = await this.setEventSeats(eventId, data.totalSeats);
+            if (!/Seats:\s*\d+/.test(seatOutput)) {
+                return { success: false, message: seatOutput.trim() || 'Failed to create seat map' };
+            }
+            
             const newEvent = {
                 ID: eventId,
                 name: data.name,
@@ -563,7 +924,14 @@ class BackendBridge {
             if (data.startDate) events[eventIndex].startDate = data.startDate;
             if (data.endDate) events[eventIndex].endDate = data.endDate;
             if (data.venue) events[eventIndex].venue = data.venue;
-            if (data.totalSeats) events[eventIndex].totalSeats = data.totalSeats;
+            if (data.totalSeats) {
+                // Resize the seat map first: the backend refuses to drop seats that are taken
+                const seatOutput = await this.setEventSeats(data.ID, data.totalSeats);
+                if (!/Seats:\s*\d+/.test(seatOutput)) {
+                    return { success: false, message: seatOutput.trim() || 'Failed to resize seat map' };
+                }
+                events[eventIndex].totalSeats = data.totalSeats;
+            }
             
             fs.writeFileSync(eventsFile, JSON.stringify(events, null, 2));
             
@@ -607,6 +975,12 @@ class BackendBridge {
         }
     }
 
+    // Create or resize an event's seat map (operation 31); returns the backend output
+    async setEventSeats(eventID, totalSeats) {
+        const inputs = ['31', eventID.toString(), (parseInt(totalSeats) || 0).toString()];
+        return this.executeCommand(inputs);
+    }
+
     // ======================= STAFF FUNCTIONS =======================
     async addStaff(data) {
         try {
@@ -630,38 +1004,21 @@ class BackendBridge {
 
     async getStaffByEvent(eventID) {
         try {
+            const cached = await this.cachedView('staff', eventID);
+            if (cached) {
+                return { success: true, staff: cached };
+            }
+
             const inputs = [
                 '14',                       // Operation: Get staff by event
                 eventID.toString()
             ];
 
-            const output = await this.executeCommand(inputs);
-            console.log('Backend staff output:', output);
-
-            const staff = [];
-            const lines = output.split('\n');
-
-            lines.forEach(line => {
+            const staff = await this.fetchView('staff', eventID, inputs, line => {
                 line = line.trim();
-                if (line.includes('ID:') && line.includes('Name:')) {
-                    const idMatch = line.match(/ID:\s*(\d+)/);
-                    const nameMatch = line.match(/Name:\s*(.+?)(?:\s+Email:|$)/);
-                    const emailMatch = line.match(/Email:\s*(.+?)(?:\s+Team:|$)/);
-                    const teamMatch = line.match(/Team:\s*(.+?)(?:\s+Position:|$)/);
-                    const positionMatch = line.match(/Position:\s*(.+?)(?:\s*$)/);
-
-                    if (idMatch) {
-                        staff.push({
-                            ID: parseInt(idMatch[1]),
-                            name: nameMatch ? nameMatch[1].trim() : 'Unknown',
-                            email: emailMatch ? emailMatch[1].trim() : 'N/A',
-                            team: teamMatch ? teamMatch[1].trim() : 'N/A',
-                            position: positionMatch ? positionMatch[1].trim() : 'N/A',
-                            eventID: eventID
-                        });
-                    }
-                }
+                return line.includes('ID:') && line.includes('Name:') ? parseStaffLine(line, eventID) : null;
             });
+            console.log('Backend staff count:', staff.length);
 
             return { success: true, staff };
         } catch (error) {
@@ -714,37 +1071,20 @@ class BackendBridge {
 
     async getVendorsByEvent(eventID) {
         try {
+            const cached = await this.cachedView('vendors', eventID);
+            if (cached) {
+                return { success: true, vendors: cached };
+            }
+
             const inputs = [
                 '17',                       // Operation: Get vendors by event
                 eventID.toString()
             ];
 
-            const output = await this.executeCommand(inputs);
-            console.log('Backend vendor output:', output);
-
-            const vendors = [];
-            const lines = output.split('\n');
-
-            lines.forEach(line => {
-                if (line.includes('ID:') && line.includes('Name:')) {
-                    const idMatch = line.match(/ID:\s*(\d+)/);
-                    const nameMatch = line.match(/Name:\s*(.+?)(?:\s+Email:|$)/);
-                    const emailMatch = line.match(/Email:\s*(.+?)(?:\s+Product\/Service:|$)/);
-                    const prodMatch = line.match(/Product\/Service:\s*(.+?)(?:\s+Charges:|$)/);
-                    const chargesMatch = line.match(/Charges:\s*(\d+)/);
-
-                    if (idMatch) {
-                        vendors.push({
-                            ID: parseInt(idMatch[1]),
-                            name: nameMatch ? nameMatch[1].trim() : 'Unknown',
-                            email: emailMatch ? emailMatch[1].trim() : 'N/A',
-                            prod_serv: prodMatch ? prodMatch[1].trim() : 'N/A',
-                            chargesDue: chargesMatch ? parseInt(chargesMatch[1]) : 0,
-                            eventID: eventID
-                        });
-                    }
-                }
+            const vendors = await this.fetchView('vendors', eventID, inputs, line => {
+                return line.includes('ID:') && line.includes('Name:') ? parseVendorLine(line, eventID) : null;
             });
+            console.log('Backend vendor count:', vendors.length);
 
             return { success: true, vendors };
         } catch (error) {
@@ -839,75 +1179,27 @@ class BackendBridge {
 
     // ======================= REGISTRATION FUNCTIONS =======================
     async registerForEvent(data) {
-        try {
-            const inputs = [
-                '12',                       // OP_ADD_REGISTRATION
-                data.custID.toString(),
-                data.eventID.toString(),
-                Math.floor(Math.random() * 90000 + 10000).toString(),
-                'Unpaid'
-            ];
-
-            const output = await this.executeCommand(inputs);
-            console.log('Backend output:', output);
-
-            const ticketMatch = output.match(/ticket number is\s*(\d+)/i);
-
-            if (output.includes('Already Registered')) {
-                const prevTicket = output.match(/ticket number is\s*(\d+)/i);
-                return {
-                    success: false,
-                    message: `Already registered! Ticket: ${prevTicket ? prevTicket[1] : 'N/A'}`
-                };
-            }
-
-            if (output.includes('successfully') || ticketMatch) {
-                return {
-                    success: true,
-                    ticketNum: ticketMatch ? parseInt(ticketMatch[1]) : 0,
-                    message: 'Registered successfully!'
-                };
-            }
-
-            return { success: false, message: 'Registration failed' };
-        } catch (error) {
-            return { success: false, message: error.message };
-        }
+        // Same path as the app's registration, so events without a seat map get one first
+        return this.customerRegister(data);
     }
 
     async getRegistrationsByEvent(eventID) {
         try {
+            const cached = await this.cachedView('registrations', eventID);
+            if (cached) {
+                return { success: true, registrations: cached };
+            }
+
             // Call backend to get registrations for this event from .dat file
             const inputs = [
                 '10',                   // Operation: Get registrations by event
                 eventID.toString()
             ];
 
-            const output = await this.executeCommand(inputs);
-            console.log('Backend registration output:', output);
-
-            const registrations = [];
-            const lines = output.split('\n');
-
-            lines.forEach(line => {
-                if (line.includes('CustID:')) {
-                    const custIdMatch = line.match(/CustID:\s*(\d+)/);
-                    const nameMatch = line.match(/Name:\s*([^\s]+(?:\s+[^\s]+)?)\s+Email:/);
-                    const emailMatch = line.match(/Email:\s*(\S+)/);
-                    const ticketMatch = line.match(/Ticket:\s*(\d+)/);
-                    const statusMatch = line.match(/Status:\s*(\w+)/);
-
-                    if (custIdMatch) {
-                        registrations.push({
-                            customerID: parseInt(custIdMatch[1]),
-                            customerName: nameMatch ? nameMatch[1] : 'Unknown',
-                            customerEmail: emailMatch ? emailMatch[1] : 'unknown@email.com',
-                            ticketNum: ticketMatch ? parseInt(ticketMatch[1]) : 0,
-                            feeStatus: statusMatch ? statusMatch[1] : 'Unpaid'
-                        });
-                    }
-                }
+            const registrations = await this.fetchView('registrations', eventID, inputs, line => {
+                return line.includes('CustID:') ? parseRegistrationLine(line) : null;
             });
+            console.log('Backend registration count:', registrations.length);
 
             return { success: true, registrations };
         } catch (error) {
@@ -968,34 +1260,38 @@ class BackendBridge {
                 return { success: false, message: 'All seats are filled for this event' };
             }
             
-            // Check if already registered
-            const registrations = readAllFromDat('registrations.dat', parseRegistration, REGISTRATION_SIZE);
-            const alreadyRegistered = registrations.find(r => 
-                r.customerID === data.custID && r.eventID === data.eventID
-            );
-            
-            if (alreadyRegistered) {
-                return { success: false, message: 'Already registered for this event' };
-            }
-            
-            // Generate ticket number
-            const ticketNum = Math.floor(Math.random() * 90000) + 10000;
-            
-            // Call backend to add registration to .dat file
+            // Call backend to add registration to .dat file; it assigns the seat, and the
+            // ticket number is the seat number
             const inputs = [
                 '12',                           // Operation: Add registration
                 data.custID.toString(),
                 data.eventID.toString(),
-                ticketNum.toString(),
+                '0',
                 'Unpaid'
             ];
 
-            const output = await this.executeCommand(inputs);
+            // The backend rejects duplicates (a Bloom filter check, usually without reading the file)
+            let output = await this.executeCommand(inputs);
+            if (output.includes('No seat map')) {
+                // Event created before seat maps: create its map now, then register
+                await this.setEventSeats(data.eventID, event.totalSeats);
+                output = await this.executeCommand(inputs);
+            }
             console.log('Backend registration output:', output);
 
-            if (!output.includes('added successfully')) {
+            if (output.includes('Already Registered')) {
+                return { success: false, message: 'Already registered for this event' };
+            }
+
+            if (output.includes('Sold Out')) {
+                return { success: false, message: 'All seats are filled for this event' };
+            }
+
+            const ticketMatch = output.match(/ticket number is\s*(\d+)/i);
+            if (!output.includes('added successfully') || !ticketMatch) {
                 return { success: false, message: 'Failed to register with backend' };
             }
+            const ticketNum = parseInt(ticketMatch[1]);
             
             // Increment sold tickets for the event
             const eventIndex = events.findIndex(e => e.ID === data.eventID);
@@ -1013,6 +1309,66 @@ class BackendBridge {
         }
     }
 
+    // Book adjacent seats for a group of customers: all of them are registered or none
+    async customerBookGroup(data) {
+        try {
+            const inputs = [
+                '32',                           // Operation: Group booking
+                data.eventID.toString(),
+                data.feeStatus || 'Unpaid',
+                data.custIDs.length.toString(),
+                ...data.custIDs.map(id => id.toString())
+            ];
+            const output = await this.executeCommand(inputs);
+            if (!output.includes('booked successfully')) {
+                return { success: false, message: output.trim() || 'Group booking failed' };
+            }
+            const tickets = [];
+            output.split('\n').forEach(line => {
+                const match = line.match(/CustID:\s*(\d+)\s*Ticket:\s*(\d+)/);
+                if (match) tickets.push({ custID: parseInt(match[1]), ticketNum: parseInt(match[2]) });
+            });
+            this.adjustSoldTickets(data.eventID, tickets.length);
+            return { success: true, tickets, message: 'Group booked successfully!' };
+        } catch (error) {
+            console.error('customerBookGroup error:', error);
+            return { success: false, message: error.message };
+        }
+    }
+
+    // Cancel a registration and free its seat
+    async customerCancelRegistration(data) {
+        try {
+            const inputs = ['33', data.custID.toString(), data.eventID.toString()];
+            const output = await this.executeCommand(inputs);
+            if (!output.includes('cancelled successfully')) {
+                return { success: false, message: 'Registration not found' };
+            }
+            this.adjustSoldTickets(data.eventID, -1);
+            return { success: true, message: 'Registration cancelled!' };
+        } catch (error) {
+            console.error('customerCancelRegistration error:', error);
+            return { success: false, message: error.message };
+        }
+    }
+
+    adjustSoldTickets(eventID, delta) {
+        const eventsFile = path.join(DATA_DIR, 'events.json');
+        if (!fs.existsSync(eventsFile)) {
+            return;
+        }
+        try {
+            const events = JSON.parse(fs.readFileSync(eventsFile, 'utf8'));
+            const event = events.find(e => e.ID === eventID);
+            if (event) {
+                event.soldTickets = Math.max(0, (event.soldTickets || 0) + delta);
+                fs.writeFileSync(eventsFile, JSON.stringify(events, null, 2));
+            }
+        } catch (e) {
+            // events.json is only a display copy of the count; the seat map is authoritative
+        }
+    }
+
     async customerGetRegistrations(custID) {
         try {
             const eventsFile = path.join(DATA_DIR, 'events.json');
@@ -1027,12 +1383,14 @@ class BackendBridge {
                 }
             }
             
-            // Read registrations from .dat file
-            const registrations = readAllFromDat('registrations.dat', parseRegistration, REGISTRATION_SIZE);
+            // Read registrations from .dat files, keeping only this customer's
+            const registrations = [];
+            forEachInTable('registrations.dat', parseRegistration, REGISTRATION_SIZE, r => {
+                if (r.customerID === custID) registrations.push(r);
+            });
             
-            // Filter registrations for this customer and add event details, excluding deleted events
+            // Add event details, excluding deleted events
             const customerRegs = registrations
-                .filter(r => r.customerID === custID)
                 .filter(r => events.some(e => e.ID === r.eventID)) // Only include registrations for events that still exist
                 .map(r => {
                     const event = events.find(e => e.ID === r.eventID);
@@ -1051,6 +1409,28 @@ class BackendBridge {
         }
     }
 
+    // Write an event's registrations, staff or vendors to a CSV or NDJSON file in one backend pass
+    async exportRoster(data) {
+        try {
+            const inputs = [
+                '30',                   // Operation: Export roster
+                data.eventID.toString(),
+                data.roster,            // registrations, staff or vendors
+                data.format || 'csv',   // csv or ndjson
+                path.resolve(data.path)
+            ];
+            const output = await this.executeCommand(inputs);
+            const match = output.match(/Exported:\s*(\d+)\s*Bytes:\s*(\d+)/);
+            if (match) {
+                return { success: true, rows: parseInt(match[1]), bytes: parseInt(match[2]) };
+            }
+            return { success: false, message: output.trim() || 'Export failed' };
+        } catch (error) {
+            console.error('exportRoster error:', error);
+            return { success: false, message: error.message };
+        }
+    }
+
     async getStaffCountByEvent(eventID) {
         try {
             const inputs = ['21', eventID.toString()];
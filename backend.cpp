@@ -1,20 +1,138 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <cstddef>
+#include <cstdlib>
+#include <climits>
+#include <cctype>
+#include <cstdio>
+#include <iomanip>
+#include <string>
+#include <cerrno>
 #include <ctime>
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <queue>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <poll.h>
+#include <dirent.h>
+#else
+#include <io.h>
+#include <fcntl.h>
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef EMS_IO_URING
+// Optional io_uring backend: build with -DEMS_IO_URING (Linux 5.6+), no liburing needed
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#endif
 using namespace std;
 
-// GLOBAL FILE NAMES
-char ORG_FILE[] = "organisers.dat";
-char CUST_FILE[] = "customers.dat";
-char REG_FILE[] = "registrations.dat";
-char STAFF_FILE[] = "staff.dat";
-char VENDOR_FILE[] = "vendors.dat";
+// GLOBAL FILE NAMES (sized so the parse benchmark can point them into a scratch directory)
+const size_t FILE_NAME_SIZE = 48;
+char ORG_FILE[FILE_NAME_SIZE] = "organisers.dat";
+char CUST_FILE[FILE_NAME_SIZE] = "customers.dat";
+char REG_FILE[FILE_NAME_SIZE] = "registrations.dat";
+char STAFF_FILE[FILE_NAME_SIZE] = "staff.dat";
+char VENDOR_FILE[FILE_NAME_SIZE] = "vendors.dat";
 // Note: Events use events.json
 
+// ASYNC I/O SETTINGS
+const size_t IO_CHUNK_SIZE = 1 << 20;  // bytes per read/write request (1 MiB)
+const unsigned IO_QUEUE_DEPTH = 32;    // requests kept in flight at once
+
+// SHARDED STORAGE
+char SHARD_MANIFEST[] = "shards.manifest";  // present only once data has been migrated to shards
+int shardedModeCache = -1;                   // -1 until the manifest has been checked
+char PROCESS_LOCK[] = "backend.lock";        // held shared by every running backend, exclusively by migration
+int processLockFd = -1;
+const int PUBLISH_RETRIES = 200;             // Windows: tries at replacing a file a reader still has open
+const int PUBLISH_RETRY_MS = 10;
+
+// CHANGE FEED
+char CHANGE_LOG[FILE_NAME_SIZE] = "changes.log";
+const long long CHANGE_LOG_MAX_RECORDS = 1 << 16;   // compact the log once it holds more changes than this
+const long long CHANGE_LOG_KEEP_RECORDS = 1 << 14;  // newest changes a compaction keeps
+const int CHANGE_POLL_MS = 250;  // how often an idle server checks for changes by other processes
+bool serverMode = false;         // running as a resident server (backend --serve)
+long long subscribedSeq = -1;    // last change pushed to the subscriber, -1 when not subscribed
+
+// REQUEST DECODER
+const size_t REQUEST_BUFFER_SIZE = 1 << 16;  // largest request (incl. pipelined input) held at once
+const size_t MAX_LENGTH_LINE = 20;           // server-mode request length lines have fewer digits than this
+
+// BLOOM FILTERS
+const unsigned BLOOM_BITS_PER_KEY = 10;     // about 1% false positives when full
+const unsigned BLOOM_HASHES = 7;
+const unsigned BLOOM_KEYS_PER_RECORD = 2;   // at most: organisers/customers have ID and username
+const unsigned BLOOM_MIN_BITS = 1 << 10;
+
+// QUERY ENGINE
+const int MAX_QUERY_PREDICATES = 8;
+const int MAX_SCHEMA_FIELDS = 16;
+const size_t QUERY_BLOCK_ROWS = 1024;  // records filtered per kernel pass
+
+// THREAD POOL
+const unsigned MAX_POOL_THREADS = 8;  // threads used by a parallel step, the calling thread included
+bool poolDisabled = false;            // set by the load benchmark to time the serial baseline
+const size_t PARALLEL_IO_MIN_BYTES = 4 << 20;         // smaller batches aren't worth waking the pool
+const size_t PARALLEL_INDEX_MIN_RECORDS = 1 << 16;    // smaller tables are indexed by one thread
+
+// MEMORY BUDGET
+const size_t DEFAULT_MEMORY_MB = 256;      // bytes one operation may hold at once; EMS_MEMORY_MB overrides
+const size_t SCAN_BUDGET_SHARE = 8;        // a scan reads at most budget / 8 bytes per chunk
+const long long INDEX_OVERHEAD = 2;        // a table indexed in memory takes about twice its file size
+const size_t MAX_SPILL_PARTITIONS = 256;   // spill files per side of a join partition
+const unsigned MAX_SPILL_DEPTH = 4;        // times a join partition is split again before it is indexed whole
+const size_t RECURSION_BLOCK_RECORDS = 1 << 12;  // records per recursive count, bounding its stack depth
+size_t memoryBudgetCache = 0;              // 0 until EMS_MEMORY_MB has been read
+
+// SEAT MAPS
+char SEAT_MAP_BASE[] = "seats.dat";     // per-event seat maps are seats_e<ID>.dat
+const int MAX_EVENT_SEATS = 1 << 24;
+const int MAX_GROUP_SIZE = 100;
+
+// EXPORT
+const size_t EXPORT_CHUNK_RECORDS = 1 << 16;     // records read and formatted per round
+const size_t EXPORT_SLICE_MIN_RECORDS = 4096;    // smallest slice worth its own thread
+
 // ENUM DEFINITIONS
 
+// Change feed tables and change types
+enum ChangeTable { TABLE_REGISTRATIONS = 1, TABLE_STAFF, TABLE_VENDORS };
+enum ChangeType { CHANGE_INSERT = 1, CHANGE_UPDATE, CHANGE_DELETE };
+
+// Kinds of key held in a Bloom filter
+enum FilterKeyKind { KEY_ID = 1, KEY_USERNAME, KEY_REGISTRATION };
+
+// Query engine field types and comparison operators (~ is substring match on text)
+enum FieldType { FIELD_INT = 1, FIELD_FLOAT, FIELD_TEXT };
+enum CompareOp { CMP_EQ = 1, CMP_NE, CMP_LT, CMP_LE, CMP_GT, CMP_GE, CMP_CONTAINS };
+
+// Roster export formats
+enum ExportFormat { FORMAT_CSV = 1, FORMAT_NDJSON };
+
+// What rewriteRecords() does with one record
+enum RecordEdit { KEEP_RECORD = 1, CHANGE_RECORD, DROP_RECORD };
+
 // Event types
 enum EventType { MUN = 1, OLYMPIAD, SEMINAR, CEREMONY, FESTIVAL, CONCERT, CUSTOM };
 
@@ -45,7 +163,42 @@ enum OperationCode {
     
     // Counting operations (21-22, recursive)
     OP_GET_STAFF_COUNT = 21,
-    OP_GET_VENDOR_COUNT = 22
+    OP_GET_VENDOR_COUNT = 22,
+    
+    // Diagnostics (23)
+    OP_IO_BENCHMARK = 23,
+    
+    // Storage maintenance (24)
+    OP_MIGRATE_TO_SHARDS = 24,
+    
+    // Change feed operations (25-26)
+    OP_GET_CHANGES_SINCE = 25,
+    OP_SUBSCRIBE_CHANGES = 26,
+    
+    // Diagnostics (27)
+    OP_PARSE_BENCHMARK = 27,
+    
+    // Query operations (28)
+    OP_QUERY = 28,
+    
+    // Diagnostics (29)
+    OP_FILTER_STATS = 29,
+    
+    // Export operations (30)
+    OP_EXPORT_ROSTER = 30,
+    
+    // Seat operations (31-34)
+    OP_SET_EVENT_SEATS = 31,
+    OP_BOOK_GROUP = 32,
+    OP_CANCEL_REGISTRATION = 33,
+    OP_SEAT_STATUS = 34,
+    
+    // Diagnostics (35-36)
+    OP_SEAT_BENCHMARK = 35,
+    OP_LOAD_BENCHMARK = 36,
+    
+    // Authentication operations (37)
+    OP_CHECK_USERNAME = 37
 };
 
 // STRUCT DEFINITIONS
@@ -84,6 +237,254 @@ struct Registration {
     char feeStatus[10];
 };
 
+// One whole data file loaded into memory by loadFiles()
+struct FileLoad {
+    const char* filename;
+    vector<char> data;
+    bool exists;
+};
+
+// One chunk of a batched read or write
+struct IoRequest {
+    int fd;
+    char* buf;
+    size_t len;
+    long long offset;
+};
+
+// A file written a batch at a time by writeData(): chunked writes through runIoBatch
+struct DataWriter {
+#ifdef _WIN32
+    ofstream file;
+#else
+    int fd;
+    long long offset;   // where the next batch goes
+#endif
+    bool ok;
+};
+
+// Part of one file read into a scan window (scanFiles)
+struct ScanPiece {
+    size_t file;        // index into the scan's paths
+    long long offset;   // byte range read from the file...
+    size_t length;
+    size_t position;    // ...and where it lands in the window
+};
+
+// One line of shards.manifest: a per-event shard of a global table
+struct ShardEntry {
+    char baseFile[32];
+    int eventID;
+};
+
+// One entry of a <table>.ids directory: which event shard holds a staff/vendor ID
+struct ShardDirEntry {
+    int ID, eventID;
+};
+
+// One entry of changes.log; its sequence number is its position in the log. A compacted log
+// starts with a header entry (table 0) whose data holds the number of changes dropped before it.
+struct ChangeRecord {
+    int table, type, eventID, recordID;  // recordID is the customer ID for registrations
+    union {
+        Registration reg;
+        Staff staff;
+        Vendor vendor;
+    } data;  // record after the change (before it, for deletes)
+};
+
+// Start of a <stem>.bloom file; the filter's bits follow it
+struct BloomHeader {
+    char magic[8];               // "EMSBLOOM"
+    long long dataSize;          // data file size the filter covers
+    unsigned long long dataIno;  // data file inode it covers (a rewrite publishes a new one)
+    unsigned bitCount;           // power of two
+    unsigned hashCount;
+    unsigned keyCount;
+    unsigned reserved;
+};
+
+// A data file's Bloom filter as held in memory, with this process's check counts
+struct BloomFilter {
+    BloomHeader header;
+    vector<unsigned char> bits;
+    vector<unsigned> dirty;      // bytes changed since the filter file was last written
+    long long checks, negatives, falsePositives;
+    bool pendingMaybe;           // the last check said "maybe"
+    BloomFilter() : checks(0), negatives(0), falsePositives(0), pendingMaybe(false) { header.bitCount = 0; }
+};
+
+// Start of a seats_e<ID>.dat seat map; the free-seat bitmap follows in 64-bit words
+struct SeatMapHeader {
+    char magic[8];      // "EMSSEATS"
+    int eventID;
+    int seatCount;
+    int freeCount;
+    int reserved;
+    long long version;  // bumped by every change, so cached copies can tell they are stale
+};
+
+// An event's seat map as held in memory. levels[0] has a bit per seat (set = free); each
+// higher level has a bit per word of the level below, set while that word has a free seat.
+struct SeatMap {
+    SeatMapHeader header;
+    unsigned long long ino;                        // map file the cached copy was read from
+    vector< vector<unsigned long long> > levels;   // up to a single top word
+    vector<size_t> dirty;                          // words of levels[0] changed since the last write
+};
+
+// One field of a record type, located by its offset in the struct
+struct FieldDesc {
+    const char* name;
+    FieldType type;
+    size_t offset, size;
+    bool hidden;  // never filtered on or returned by queries (passwords)
+};
+
+// One record type: its data file, record size and fields
+struct TableSchema {
+    const char* name;
+    const char* file;
+    size_t recordSize;
+    const FieldDesc* fields;
+    int fieldCount;
+    int idField;     // field mapped to its shard by <table>.ids, -1 if none
+    int eventField;  // field the table is sharded on, -1 if not sharded
+    unsigned filterKeys;  // 1 << FilterKeyKind for each lookup key its Bloom filters hold
+    bool (*mayContain)(const char* dataFile, FilterKeyKind kind, const void* key, size_t len);
+};
+
+// One "<field> <op> <value>" condition of a query, with the scan kernel chosen for it
+struct QueryPredicate {
+    const FieldDesc* field;
+    CompareOp op;
+    int intValue;
+    float floatValue;
+    char textValue[64];
+    size_t textLen;
+    size_t (*kernel)(const char* data, size_t recordSize, const QueryPredicate& pred, unsigned* rows, size_t count);
+};
+
+// SCHEMA DESCRIPTORS
+// Compile-time field tables for every record type, used by the query engine
+#define SCHEMA_FIELD(record, member, type, hidden) \
+    { #member, type, offsetof(record, member), sizeof(static_cast<record*>(0)->member), hidden }
+
+constexpr FieldDesc ORGANISER_FIELDS[] = {
+    SCHEMA_FIELD(Organiser, ID, FIELD_INT, false),
+    SCHEMA_FIELD(Organiser, name, FIELD_TEXT, false),
+    SCHEMA_FIELD(Organiser, email, FIELD_TEXT, false),
+    SCHEMA_FIELD(Organiser, username, FIELD_TEXT, false),
+    SCHEMA_FIELD(Organiser, password, FIELD_TEXT, true)
+};
+
+constexpr FieldDesc CUSTOMER_FIELDS[] = {
+    SCHEMA_FIELD(Customer, ID, FIELD_INT, false),
+    SCHEMA_FIELD(Customer, name, FIELD_TEXT, false),
+    SCHEMA_FIELD(Customer, email, FIELD_TEXT, false),
+    SCHEMA_FIELD(Customer, username, FIELD_TEXT, false),
+    SCHEMA_FIELD(Customer, password, FIELD_TEXT, true)
+};
+
+constexpr FieldDesc STAFF_FIELDS[] = {
+    SCHEMA_FIELD(Staff, ID, FIELD_INT, false),
+    SCHEMA_FIELD(Staff, eventID, FIELD_INT, false),
+    SCHEMA_FIELD(Staff, name, FIELD_TEXT, false),
+    SCHEMA_FIELD(Staff, email, FIELD_TEXT, false),
+    SCHEMA_FIELD(Staff, team, FIELD_TEXT, false),
+    SCHEMA_FIELD(Staff, position, FIELD_TEXT, false)
+};
+
+constexpr FieldDesc VENDOR_FIELDS[] = {
+    SCHEMA_FIELD(Vendor, ID, FIELD_INT, false),
+    SCHEMA_FIELD(Vendor, eventID, FIELD_INT, false),
+    SCHEMA_FIELD(Vendor, name, FIELD_TEXT, false),
+    SCHEMA_FIELD(Vendor, email, FIELD_TEXT, false),
+    SCHEMA_FIELD(Vendor, prod_serv, FIELD_TEXT, false),
+    SCHEMA_FIELD(Vendor, chargesDue, FIELD_FLOAT, false)
+};
+
+constexpr FieldDesc REGISTRATION_FIELDS[] = {
+    SCHEMA_FIELD(Registration, customerID, FIELD_INT, false),
+    SCHEMA_FIELD(Registration, eventID, FIELD_INT, false),
+    SCHEMA_FIELD(Registration, ticketNum, FIELD_INT, false),
+    SCHEMA_FIELD(Registration, feeStatus, FIELD_TEXT, false)
+};
+
+template<size_t N>
+constexpr int fieldCount(const FieldDesc (&)[N]) { return (int)N; }
+
+// Bloom filter test for one record type (see the Bloom filter functions)
+template<typename T> bool filterMayContain(const char* dataFile, FilterKeyKind kind, const void* key, size_t len);
+
+// Events live in events.json, which the backend doesn't read, so they can't be queried
+constexpr TableSchema SCHEMAS[] = {
+    { "organisers", ORG_FILE, sizeof(Organiser), ORGANISER_FIELDS, fieldCount(ORGANISER_FIELDS), -1, -1,
+      (1 << KEY_ID) | (1 << KEY_USERNAME), filterMayContain<Organiser> },
+    { "customers", CUST_FILE, sizeof(Customer), CUSTOMER_FIELDS, fieldCount(CUSTOMER_FIELDS), -1, -1,
+      (1 << KEY_ID) | (1 << KEY_USERNAME), filterMayContain<Customer> },
+    { "staff", STAFF_FILE, sizeof(Staff), STAFF_FIELDS, fieldCount(STAFF_FIELDS), 0, 1,
+      1 << KEY_ID, filterMayContain<Staff> },
+    { "vendors", VENDOR_FILE, sizeof(Vendor), VENDOR_FIELDS, fieldCount(VENDOR_FIELDS), 0, 1,
+      1 << KEY_ID, filterMayContain<Vendor> },
+    { "registrations", REG_FILE, sizeof(Registration), REGISTRATION_FIELDS, fieldCount(REGISTRATION_FIELDS), -1, 1,
+      1 << KEY_REGISTRATION, filterMayContain<Registration> }
+};
+const int SCHEMA_COUNT = sizeof(SCHEMAS) / sizeof(SCHEMAS[0]);
+
+// Worker threads shared by every parallel step; see runParallel()
+struct ThreadPool {
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wake, done;
+    const function<void(size_t)>* job;  // current job, run as tasks 0..taskCount-1
+    size_t taskCount;
+    atomic<size_t> nextTask;
+    unsigned busy;                      // workers still on the current job
+    unsigned long long generation;      // bumped per job, so each worker joins each job once
+    ThreadPool() : job(NULL), taskCount(0), nextTask(0), busy(0), generation(0) {}
+};
+
+// ID -> record position over a loaded table, split into partitions built in parallel
+struct RecordIndex {
+    vector< unordered_map<int, size_t> > parts;  // partition p holds the keys with key % parts == p
+};
+
+// An event's registration in a join's spill file, numbered by its place in the event's list
+struct SpilledRegistration {
+    long long seq;
+    Registration reg;
+};
+
+// One row of a join partition's output: the registration and its customer, if there is one
+struct JoinedRegistration {
+    long long seq;
+    Registration reg;
+    Customer cust;
+    int found;
+};
+
+// One output column of a roster export
+struct ExportColumn {
+    const char* name;
+    const FieldDesc* field;
+    bool fromJoin;  // taken from the joined customer record, not the roster's own record
+};
+
+// Input buffer of one connection (stdin); the current request is buffer[start, end)
+struct RequestReader {
+    char buffer[REQUEST_BUFFER_SIZE];
+    size_t start, end;      // unread part of the current request
+    size_t next;            // where the following request begins
+    size_t buffered;        // bytes read from stdin so far
+    size_t bodyStart;       // server mode: where the current request's body begins...
+    size_t bodySize;        // ...and its length from the request's length line
+    bool haveLength;        // the current request's length line has been read
+    size_t discardLeft;     // bytes still to drop from an oversized request
+    const char* error;      // first decode error of the current request, NULL if none
+    bool closed;            // stdin reached EOF
+};
+
 // FUNCTION PROTOTYPES
 
 // Utility functions
@@ -93,7 +494,137 @@ bool searchCustomerID(int targetID);
 bool searchEventID(int targetID);
 bool searchStaffID(int targetID);
 bool searchVendorID(int targetID);
-bool searchRegistration(int eventID, int custID);
+bool searchRegistration(int eventID, int custID, int& ticketNum);
+template<typename T> bool searchUsername(const char* filename, const char* username);
+
+// Thread pool functions
+unsigned poolThreads();
+void runParallel(size_t tasks, const function<void(size_t)>& task);
+void buildRecordIndex(const char* data, size_t recordSize, size_t count, size_t keyOffset, RecordIndex& index);
+long long findIndexedRecord(const RecordIndex& index, int key);
+
+// Async I/O functions
+bool loadFiles(vector<FileLoad>& files);
+bool openDataWriter(DataWriter& out, const char* filename);
+bool writeData(DataWriter& out, const char* data, size_t size);
+bool closeDataWriter(DataWriter& out);
+bool writeFileData(const char* filename, const char* data, size_t size);
+template<typename T> bool loadRecords(const char* filename, vector<T>& records);
+template<typename T> bool appendRecord(const char* filename, const T& record);
+void evictFile(const char* filename);
+void ioBenchmark();
+void loadBenchmark();
+
+// Snapshot and locking functions
+void tempFileName(const char* filename, char* out, size_t outSize);
+bool publishFile(const char* tempName, const char* filename);
+int lockTable(const char* filename);
+int tryLockTable(const char* filename);
+int lockIDs(const char* baseFile);
+int lockEventSeats(int eventID);
+void unlockTable(int lockFd);
+void holdProcessLock();
+bool lockOutOtherProcesses();
+void letOtherProcessesIn();
+
+// Memory budget functions
+size_t memoryBudget();
+size_t scanChunkRecords(size_t recordSize);
+bool fitsInMemory(long long bytes);
+bool scanFiles(const vector<string>& paths, size_t recordSize, const function<bool(const char*, size_t)>& visit);
+bool scanFilesLoading(const vector<string>& paths, size_t recordSize, vector<FileLoad>& alongside, const function<bool(const char*, size_t)>& visit);
+template<typename T> bool scanRecords(const char* filename, const function<bool(const T*, size_t)>& visit);
+template<typename T> bool scanRecordsLoading(const char* filename, vector<FileLoad>& alongside, const function<bool(const T*, size_t)>& visit);
+bool copyFilePrefix(const char* filename, DataWriter& out, long long bytes);
+template<typename T> bool rewriteRecords(const char* filename, const function<RecordEdit(T&)>& edit, size_t& edits);
+void spillFileName(const char* tag, unsigned level, size_t part, char* out, size_t outSize);
+size_t spillPartition(int customerID, unsigned level, size_t parts);
+bool joinRegistrations(const char* regFile, int eventID, const function<void(const Registration&, const Customer*)>& visit);
+bool spillJoinRegistrations(const char* regFile, int eventID, long long custSize, const function<void(const Registration&, const Customer*)>& visit);
+bool joinSpillPartition(const char* custFile, long long custSize, const char* regFile, unsigned level, const function<void(const JoinedRegistration&)>& emit);
+
+// Sharded storage functions
+bool isShardedMode();
+void shardFileName(const char* baseFile, int eventID, char* out, size_t outSize);
+void shardDirectoryName(const char* baseFile, char* out, size_t outSize);
+const char* eventFile(const char* baseFile, int eventID, char* buf, size_t bufSize);
+bool loadShardManifest(vector<ShardEntry>& entries);
+bool findShardedID(const char* baseFile, int targetID, int& eventID);
+const char* recordFile(const char* baseFile, int recordID, char* buf, size_t bufSize);
+template<typename T> bool appendEventRecord(const char* baseFile, int eventID, int recordID, const T& record);
+void migrateToShards();
+
+// Bloom filter functions
+void filterFileName(const char* dataFile, char* out, size_t outSize);
+bool dataIdentity(const char* filename, long long& size, unsigned long long& ino);
+template<typename T> bool filterMayContain(const char* dataFile, FilterKeyKind kind, const void* key, size_t len);
+void filterScanMissed(const char* dataFile);
+template<typename T> void filterAppend(const char* dataFile, long long sizeBefore, unsigned long long inoBefore, const T& record);
+void invalidateFilter(const char* dataFile);
+void filterStats();
+
+// Seat map functions
+void seatMapFileName(int eventID, char* out, size_t outSize);
+void initSeatMap(SeatMap& map, int eventID, int seatCount);
+long long nextSetBit(const SeatMap& map, size_t level, size_t index);
+long long nextTakenSeat(const SeatMap& map, long long seat, long long limit);
+long long findSeatBlock(const SeatMap& map, int count);
+void takeSeat(SeatMap& map, long long seat);
+void releaseSeat(SeatMap& map, long long seat);
+void returnSeats(SeatMap& map, long long start, int count);
+SeatMap* currentSeatMap(int eventID);
+bool saveSeatMap(SeatMap& map);
+bool updateSeatMapFile(SeatMap& map);
+void setEventSeats();
+void bookGroup();
+void cancelRegistration();
+void seatStatus();
+void seatBenchmark();
+
+// Change feed functions
+void logChange(ChangeTable table, ChangeType type, int eventID, int recordID, const void* record, size_t size);
+bool openChangeLog(ifstream& log, long long& firstSeq, long long& latestSeq, long long& offset);
+void compactChangeLog();
+long long latestChangeSequence();
+bool loadChangesSince(long long seq, vector<ChangeRecord>& changes, long long& firstSeq);
+void printChange(long long seq, const ChangeRecord& change);
+void getChangesSince();
+void subscribeChanges();
+void pushChanges();
+
+// Request decoder functions
+bool fillRequestBuffer();
+bool readWholeRequest();
+bool findFramedRequest();
+void finishRequest();
+bool nextToken(char* token, size_t tokenSize);
+bool nextInt(int& value);
+bool nextLong(long long& value);
+bool nextFloat(float& value);
+bool nextText(char* dest, size_t destSize);
+bool requestOK();
+void parseBenchmark();
+
+// Query engine functions
+const TableSchema* findSchema(const char* name);
+int findField(const TableSchema& schema, const char* name, size_t len);
+bool parsePredicate(const TableSchema& schema, const char* line, QueryPredicate& pred);
+int parseProjection(const TableSchema& schema, const char* list, int* columns);
+const char* chooseQueryFiles(const TableSchema& schema, const QueryPredicate* preds, int predCount, vector<string>& files);
+bool filterQueryFiles(const TableSchema& schema, const QueryPredicate* preds, int predCount, vector<string>& files);
+void printQueryRow(const TableSchema& schema, const char* record, const int* columns, int columnCount);
+void runQuery();
+
+// Export functions
+void appendExportText(string& out, const char* text, size_t len, ExportFormat format);
+void appendExportRow(string& out, const vector<ExportColumn>& columns, const char* record, const char* joined, ExportFormat format);
+bool exportColumns(const char* roster, const TableSchema*& schema, vector<ExportColumn>& columns);
+void exportRoster();
+
+// Server mode functions
+bool waitForRequest();
+void serveRequests();
+void dispatchOperation(int operation);
 
 // Organiser functions
 void organiserSignup();
@@ -102,6 +633,7 @@ void organiserLogin();
 // Customer functions
 void customerSignup();
 void customerLogin();
+void checkUsername();
 
 // Event functions
 void addEvent();
@@ -128,21 +660,53 @@ void getRegistrationsByEvent();
 void updateRegistrationFeeStatus();
 
 // Recursive functions
-int countStaffByEventRecursive(vector<Staff>& staff, int index, int eventID);
-int countVendorsByEventRecursive(vector<Vendor>& vendors, int index, int eventID);
+int countStaffByEventRecursive(const Staff* staff, size_t count, size_t index, int eventID);
+int countVendorsByEventRecursive(const Vendor* vendors, size_t count, size_t index, int eventID);
 void getStaffCountByEvent();
 void getVendorCountByEvent();
 
+// Bloom filters loaded by this process, by data file name
+unordered_map<string, BloomFilter> filterCache;
+
+// Seat maps loaded by this process, by event ID
+unordered_map<int, SeatMap> seatMapCache;
+
+// The one connection: stdin, decoded through a static buffer
+RequestReader stdinReader;
+RequestReader* input = &stdinReader;
+
 // Main entry point
-int main() {
+int main(int argc, char* argv[]) {
     srand((unsigned)time(0));
     // used to ensure distinct random numbers are generated by rand() during execution
     // by using current time as seed
     
+    // Output is written in batches: flushed once per request (or at exit), not per line
+    ios::sync_with_stdio(false);
+    
+    // Keeps shard migration out while this process runs (see migrateToShards)
+    holdProcessLock();
+    
+    // "backend --serve" stays resident and handles many requests (see serveRequests)
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        serveRequests();
+        return 0;
+    }
+    
+    // Single operation per execution
+    readWholeRequest();
     int operation;
-    cin >> operation;
+    if (nextInt(operation)) {
+        dispatchOperation(operation);
+    } else {
+        requestOK();
+    }
     
-    // Handle all operation codes (single operation per execution)
+    return 0;
+}
+
+void dispatchOperation(int operation) {
+    // Handle all operation codes
     switch (static_cast<OperationCode>(operation)) {
         // Authentication operations
         case OP_ORGANISER_SIGNUP:
@@ -204,209 +768,3657 @@ int main() {
         case OP_GET_VENDOR_COUNT:
             getVendorCountByEvent();
             break;
+        
+        // Diagnostics
+        case OP_IO_BENCHMARK:
+            ioBenchmark();
+            break;
+        
+        // Storage maintenance
+        case OP_MIGRATE_TO_SHARDS:
+            migrateToShards();
+            break;
+        
+        // Change feed operations
+        case OP_GET_CHANGES_SINCE:
+            getChangesSince();
+            break;
+        case OP_SUBSCRIBE_CHANGES:
+            subscribeChanges();
+            break;
+        
+        // Diagnostics
+        case OP_PARSE_BENCHMARK:
+            parseBenchmark();
+            break;
+        
+        // Query operations
+        case OP_QUERY:
+            runQuery();
+            break;
+        
+        // Diagnostics
+        case OP_FILTER_STATS:
+            filterStats();
+            break;
+        
+        // Export operations
+        case OP_EXPORT_ROSTER:
+            exportRoster();
+            break;
+        
+        // Seat operations
+        case OP_SET_EVENT_SEATS:
+            setEventSeats();
+            break;
+        case OP_BOOK_GROUP:
+            bookGroup();
+            break;
+        case OP_CANCEL_REGISTRATION:
+            cancelRegistration();
+            break;
+        case OP_SEAT_STATUS:
+            seatStatus();
+            break;
+        
+        // Diagnostics
+        case OP_SEAT_BENCHMARK:
+            seatBenchmark();
+            break;
+        case OP_LOAD_BENCHMARK:
+            loadBenchmark();
+            break;
+        
+        // Authentication operations
+        case OP_CHECK_USERNAME:
+            checkUsername();
+            break;
+    }
+}
+
+// Utility function definitions
+bool isEmptyFile(const char* filename) {
+    // Check if file is empty by attempting to read first byte
+    ifstream file(filename, ios::binary);
+    if (!file) return true;  // if the file doesn't exist, return true meaning empty
+    bool isEmpty = file.peek() == EOF;  // Check if immediately end of file is reached
+    file.close();
+    return isEmpty;
+}
+
+bool searchOrganiserID(int targetID) {
+    // Search binary file for organiser with matching ID, unless the Bloom filter rules it out
+    if (!filterMayContain<Organiser>(ORG_FILE, KEY_ID, &targetID, sizeof(int))) return false;
+    bool found = false;
+    if (!scanRecords<Organiser>(ORG_FILE, [&](const Organiser* orgs, size_t count) {
+        for (size_t i = 0; i < count && !found; i++) found = orgs[i].ID == targetID;  // Found matching ID
+        return !found;
+    })) return false;
+    if (!found) filterScanMissed(ORG_FILE);
+    return found;
+}
+
+bool searchCustomerID(int targetID) {
+    if (!filterMayContain<Customer>(CUST_FILE, KEY_ID, &targetID, sizeof(int))) return false;
+    bool found = false;
+    if (!scanRecords<Customer>(CUST_FILE, [&](const Customer* custs, size_t count) {
+        for (size_t i = 0; i < count && !found; i++) found = custs[i].ID == targetID;
+        return !found;
+    })) return false;
+    if (!found) filterScanMissed(CUST_FILE);
+    return found;
+}
+
+bool searchEventID(int targetID) {
+    // Events are stored as JSON on frontend, always return false
+    return false;
+}
+
+bool searchStaffID(int targetID) {
+    int eventID;
+    if (isShardedMode()) {
+        char dirName[64];
+        shardDirectoryName(STAFF_FILE, dirName, sizeof(dirName));
+        if (!filterMayContain<ShardDirEntry>(dirName, KEY_ID, &targetID, sizeof(int))) return false;
+        if (findShardedID(STAFF_FILE, targetID, eventID)) return true;
+        filterScanMissed(dirName);
+        return false;
+    }
+    if (!filterMayContain<Staff>(STAFF_FILE, KEY_ID, &targetID, sizeof(int))) return false;
+    bool found = false;
+    if (!scanRecords<Staff>(STAFF_FILE, [&](const Staff* staff, size_t count) {
+        for (size_t i = 0; i < count && !found; i++) found = staff[i].ID == targetID;
+        return !found;
+    })) return false;
+    if (!found) filterScanMissed(STAFF_FILE);
+    return found;
+}
+
+bool searchVendorID(int targetID) {
+    int eventID;
+    if (isShardedMode()) {
+        char dirName[64];
+        shardDirectoryName(VENDOR_FILE, dirName, sizeof(dirName));
+        if (!filterMayContain<ShardDirEntry>(dirName, KEY_ID, &targetID, sizeof(int))) return false;
+        if (findShardedID(VENDOR_FILE, targetID, eventID)) return true;
+        filterScanMissed(dirName);
+        return false;
+    }
+    if (!filterMayContain<Vendor>(VENDOR_FILE, KEY_ID, &targetID, sizeof(int))) return false;
+    bool found = false;
+    if (!scanRecords<Vendor>(VENDOR_FILE, [&](const Vendor* vendors, size_t count) {
+        for (size_t i = 0; i < count && !found; i++) found = vendors[i].ID == targetID;
+        return !found;
+    })) return false;
+    if (!found) filterScanMissed(VENDOR_FILE);
+    return found;
+}
+
+bool searchRegistration(int eventID, int custID, int& ticketNum) {
+    // Find a customer's registration for an event and its ticket number
+    char path[64];
+    const char* filename = eventFile(REG_FILE, eventID, path, sizeof(path));
+    int pair[2] = { eventID, custID };
+    if (!filterMayContain<Registration>(filename, KEY_REGISTRATION, pair, sizeof(pair))) return false;
+    bool found = false;
+    if (!scanRecords<Registration>(filename, [&](const Registration* regs, size_t count) {
+        for (size_t i = 0; i < count && !found; i++) {
+            if (regs[i].customerID == custID && regs[i].eventID == eventID) {
+                ticketNum = regs[i].ticketNum;
+                found = true;
+            }
+        }
+        return !found;
+    })) return false;
+    if (!found) filterScanMissed(filename);
+    return found;
+}
+
+template<typename T>
+bool searchUsername(const char* filename, const char* username) {
+    // Organisers and customers: the Bloom filter answers most unused usernames without a scan
+    if (!filterMayContain<T>(filename, KEY_USERNAME, username, strlen(username))) return false;
+    bool found = false;
+    if (!scanRecords<T>(filename, [&](const T* records, size_t count) {
+        for (size_t i = 0; i < count && !found; i++) found = strcmp(records[i].username, username) == 0;
+        return !found;
+    })) return false;
+    if (!found) filterScanMissed(filename);
+    return found;
+}
+
+// Thread pool function definitions
+// One set of worker threads, started on the first parallel step and kept for the life of the
+// process (a resident server reuses them for every request). runParallel() hands a job of
+// numbered tasks to the workers and joins in itself; it is only called from the main thread
+// and tasks never call it again, so one job runs at a time.
+
+void runPoolTasks(ThreadPool& pool) {
+    for (size_t i = pool.nextTask++; i < pool.taskCount; i = pool.nextTask++) (*pool.job)(i);
+}
+
+void poolWorker(ThreadPool* pool) {
+    unsigned long long seen = 0;
+    for (;;) {
+        unique_lock<mutex> guard(pool->lock);
+        pool->wake.wait(guard, [&]() { return pool->generation != seen; });
+        seen = pool->generation;
+        guard.unlock();
+        runPoolTasks(*pool);
+        guard.lock();
+        if (--pool->busy == 0) pool->done.notify_one();
+    }
+}
+
+ThreadPool& threadPool() {
+    // Never destroyed: idle workers simply end with the process
+    static ThreadPool* pool = NULL;
+    if (!pool) {
+        pool = new ThreadPool();
+        unsigned threads = thread::hardware_concurrency();
+        if (threads > MAX_POOL_THREADS) threads = MAX_POOL_THREADS;
+        for (unsigned t = 1; t < threads; t++) pool->workers.push_back(thread(poolWorker, pool));
+    }
+    return *pool;
+}
+
+unsigned poolThreads() {
+    // Threads a parallel step can use, the calling thread included
+    return poolDisabled ? 1 : (unsigned)threadPool().workers.size() + 1;
+}
+
+void runParallel(size_t tasks, const function<void(size_t)>& task) {
+    // Run task(0..tasks-1) across the pool and wait for all of them
+    if (tasks <= 1 || poolThreads() == 1) {
+        for (size_t i = 0; i < tasks; i++) task(i);
+        return;
+    }
+    ThreadPool& pool = threadPool();
+    {
+        lock_guard<mutex> guard(pool.lock);
+        pool.job = &task;
+        pool.taskCount = tasks;
+        pool.nextTask = 0;
+        pool.busy = (unsigned)pool.workers.size();
+        pool.generation++;
+    }
+    pool.wake.notify_all();
+    runPoolTasks(pool);
+    unique_lock<mutex> guard(pool.lock);
+    pool.done.wait(guard, [&]() { return pool.busy == 0; });
+    pool.job = NULL;
+}
+
+void buildRecordIndex(const char* data, size_t recordSize, size_t count, size_t keyOffset, RecordIndex& index) {
+    // One partition per pool thread, each built by one task that scans the records in order,
+    // so the first record with an ID wins as in a linear scan
+    size_t parts = count < PARALLEL_INDEX_MIN_RECORDS ? 1 : poolThreads();
+    index.parts.assign(parts, unordered_map<int, size_t>());
+    runParallel(parts, [&](size_t p) {
+        unordered_map<int, size_t>& part = index.parts[p];
+        part.reserve(count / parts + 1);
+        for (size_t i = 0; i < count; i++) {
+            int key;
+            memcpy(&key, data + i * recordSize + keyOffset, sizeof(int));
+            if ((unsigned)key % parts == p) part.emplace(key, i);
+        }
+    });
+}
+
+long long findIndexedRecord(const RecordIndex& index, int key) {
+    // Position of the first record with this key, -1 if none
+    const unordered_map<int, size_t>& part = index.parts[(unsigned)key % index.parts.size()];
+    unordered_map<int, size_t>::const_iterator it = part.find(key);
+    return it == part.end() ? -1 : (long long)it->second;
+}
+
+// Async I/O function definitions
+// Files are read and written in IO_CHUNK_SIZE requests with up to IO_QUEUE_DEPTH in flight,
+// spread across every file in the batch, so multi-file operations keep the disk queue full
+// instead of issuing one small read per record.
+
+#ifdef EMS_IO_URING
+// Minimal io_uring ring driven through raw syscalls
+struct IoRing {
+    int fd;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    io_uring_sqe* sqes;
+    io_uring_cqe* cqes;
+    void* sqPtr;
+    void* cqPtr;
+    size_t sqSize, cqSize, sqesSize;
+};
+
+bool ioRingInit(IoRing& ring, unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring.fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring.fd < 0) return false;  // kernel without io_uring (or blocked): caller falls back
+
+    ring.sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        if (ring.cqSize > ring.sqSize) ring.sqSize = ring.cqSize;
+        ring.cqSize = ring.sqSize;
+    }
+
+    ring.sqPtr = mmap(0, ring.sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+    if (ring.sqPtr == MAP_FAILED) {
+        close(ring.fd);
+        return false;
+    }
+    ring.cqPtr = singleMap ? ring.sqPtr
+        : mmap(0, ring.cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+    ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqesPtr = mmap(0, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if (ring.cqPtr == MAP_FAILED || sqesPtr == MAP_FAILED) {
+        munmap(ring.sqPtr, ring.sqSize);
+        if (!singleMap && ring.cqPtr != MAP_FAILED) munmap(ring.cqPtr, ring.cqSize);
+        close(ring.fd);
+        return false;
+    }
+
+    char* sq = static_cast<char*>(ring.sqPtr);
+    char* cq = static_cast<char*>(ring.cqPtr);
+    ring.sqHead = (unsigned*)(sq + params.sq_off.head);
+    ring.sqTail = (unsigned*)(sq + params.sq_off.tail);
+    ring.sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring.sqArray = (unsigned*)(sq + params.sq_off.array);
+    ring.cqHead = (unsigned*)(cq + params.cq_off.head);
+    ring.cqTail = (unsigned*)(cq + params.cq_off.tail);
+    ring.cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring.cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring.sqes = static_cast<io_uring_sqe*>(sqesPtr);
+    return true;
+}
+
+void ioRingClose(IoRing& ring) {
+    munmap(ring.sqes, ring.sqesSize);
+    if (ring.cqPtr != ring.sqPtr) munmap(ring.cqPtr, ring.cqSize);
+    munmap(ring.sqPtr, ring.sqSize);
+    close(ring.fd);
+}
+
+// Take every posted completion off the ring; short transfers and EAGAIN go back on the retry list
+void ioRingReap(IoRing& ring, vector<IoRequest>& reqs, vector<size_t>& retry, size_t& inFlight, bool& ok) {
+    unsigned head = *ring.cqHead;
+    while (head != __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE)) {
+        io_uring_cqe* cqe = &ring.cqes[head & *ring.cqMask];
+        IoRequest& req = reqs[cqe->user_data];
+        if (cqe->res == -EAGAIN || cqe->res == -EINTR) {
+            retry.push_back(cqe->user_data);
+        } else if (cqe->res <= 0) {
+            if (cqe->res < 0) ok = false;
+            req.len = 0;  // error or EOF (file shrank): drop the rest of this chunk
+        } else if ((size_t)cqe->res < req.len) {
+            req.buf += cqe->res;
+            req.offset += cqe->res;
+            req.len -= cqe->res;
+            retry.push_back(cqe->user_data);
+        }
+        head++;
+        inFlight--;
+    }
+    __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+}
+
+// Run every request through the ring; short transfers are resubmitted for the remainder
+bool ioRingRun(IoRing& ring, vector<IoRequest>& reqs, bool isWrite) {
+    size_t next = 0, inFlight = 0;
+    unsigned queued = 0;  // entries written to the submission ring that the kernel hasn't taken yet
+    vector<size_t> retry;
+    bool ok = true;
+
+    while (ok && (next < reqs.size() || !retry.empty() || queued > 0 || inFlight > 0)) {
+        unsigned tail = *ring.sqTail;
+        while (inFlight + queued < IO_QUEUE_DEPTH && (!retry.empty() || next < reqs.size())) {
+            size_t idx;
+            if (!retry.empty()) {
+                idx = retry.back();
+                retry.pop_back();
+            } else {
+                idx = next++;
+            }
+            unsigned slot = tail & *ring.sqMask;
+            io_uring_sqe* sqe = &ring.sqes[slot];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = isWrite ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe->fd = reqs[idx].fd;
+            sqe->addr = (unsigned long long)reqs[idx].buf;
+            sqe->len = (unsigned)reqs[idx].len;
+            sqe->off = (unsigned long long)reqs[idx].offset;
+            sqe->user_data = idx;
+            ring.sqArray[slot] = slot;
+            tail++;
+            queued++;
+        }
+        __atomic_store_n(ring.sqTail, tail, __ATOMIC_RELEASE);
+
+        // A short submit leaves the rest queued in the ring; they go with the next call
+        int rc = (int)syscall(__NR_io_uring_enter, ring.fd, queued, 1, IORING_ENTER_GETEVENTS, 0, 0);
+        if (rc >= 0) {
+            inFlight += rc;
+            queued -= rc;
+        } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            ok = false;
+        }
+        ioRingReap(ring, reqs, retry, inFlight, ok);
+    }
+
+    // After a failure, wait out everything the kernel already holds: the caller frees the buffers
+    // as soon as this returns. Entries still queued were never submitted and die with the ring.
+    while (inFlight > 0) {
+        int rc = (int)syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, 0, 0);
+        if (rc < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) this_thread::yield();  // completions still land in the ring
+        ioRingReap(ring, reqs, retry, inFlight, ok);
+    }
+    return ok;
+}
+
+IoRing* processRing = NULL;       // see processIoRing()
+bool ioRingUnavailable = false;
+
+IoRing* processIoRing() {
+    // Set up on first use and kept for the life of the process, so a batch costs no setup
+    // syscalls or mmaps; NULL when the kernel has no io_uring. Main thread only, like runParallel().
+    if (!processRing && !ioRingUnavailable) {
+        processRing = new IoRing();
+        if (!ioRingInit(*processRing, IO_QUEUE_DEPTH)) {
+            delete processRing;
+            processRing = NULL;
+            ioRingUnavailable = true;
+        }
+    }
+    return processRing;
+}
+
+void discardIoRing() {
+    // After a failed batch the ring may still hold unsubmitted entries; the next batch gets a new one
+    if (!processRing) return;
+    ioRingClose(*processRing);
+    delete processRing;
+    processRing = NULL;
+}
+#endif
+
+#ifndef _WIN32
+// Execute a batch of chunk requests: io_uring when available, blocking pread/pwrite otherwise
+bool runIoBatch(vector<IoRequest>& reqs, bool isWrite) {
+    if (reqs.empty()) return true;
+#ifdef EMS_IO_URING
+    if (IoRing* ring = processIoRing()) {
+        if (ioRingRun(*ring, reqs, isWrite)) return true;
+        discardIoRing();
+        return false;
+    }
+#endif
+    // Large batches go to the thread pool chunk by chunk, so reads of several files and of the
+    // parts of one large file are in flight (or being copied out of the page cache) together
+    size_t total = 0;
+    for (size_t i = 0; i < reqs.size(); i++) total += reqs[i].len;
+    atomic<bool> ok(true);
+    function<void(size_t)> transfer = [&](size_t i) {
+        IoRequest& req = reqs[i];
+        while (req.len > 0) {
+            ssize_t n = isWrite ? pwrite(req.fd, req.buf, req.len, req.offset)
+                                : pread(req.fd, req.buf, req.len, req.offset);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                if (n < 0 || isWrite) ok = false;  // EOF on read is fine (file shrank)
+                return;
+            }
+            req.buf += n;
+            req.offset += n;
+            req.len -= n;
+        }
+    };
+    if (total < PARALLEL_IO_MIN_BYTES) {
+        for (size_t i = 0; i < reqs.size() && ok; i++) transfer(i);
+    } else {
+        runParallel(reqs.size(), transfer);
+    }
+    return ok;
+}
+
+// Split [buf, buf + size) into IO_CHUNK_SIZE requests against fd, starting at byte offset of the file
+void addChunks(vector<IoRequest>& reqs, int fd, char* buf, size_t size, long long offset) {
+    for (size_t off = 0; off < size; off += IO_CHUNK_SIZE) {
+        IoRequest req;
+        req.fd = fd;
+        req.buf = buf + off;
+        req.len = (size - off < IO_CHUNK_SIZE) ? size - off : IO_CHUNK_SIZE;
+        req.offset = offset + (long long)off;
+        reqs.push_back(req);
+    }
+}
+
+bool loadFilesWith(vector<FileLoad>& files, const vector<IoRequest>& ranges) {
+    // loadFiles(), with the ranged reads of a scan window in the same batch
+    vector<int> fds(files.size(), -1);
+    vector< vector<IoRequest> > perFile(files.size() + 1);
+    perFile[files.size()] = ranges;
+    size_t maxChunks = ranges.size();
+
+    // Open and size everything first, hinting the kernel so readahead runs on all files at once
+    for (size_t i = 0; i < files.size(); i++) {
+        files[i].data.clear();
+        fds[i] = open(files[i].filename, O_RDONLY);
+        files[i].exists = fds[i] >= 0;
+        if (fds[i] < 0) continue;
+        struct stat st;
+        if (fstat(fds[i], &st) != 0) continue;
+        files[i].data.resize((size_t)st.st_size);
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fds[i], 0, 0, POSIX_FADV_SEQUENTIAL);
+        posix_fadvise(fds[i], 0, 0, POSIX_FADV_WILLNEED);
+#endif
+        addChunks(perFile[i], fds[i], files[i].data.data(), files[i].data.size(), 0);
+        if (perFile[i].size() > maxChunks) maxChunks = perFile[i].size();
+    }
+
+    // Interleave chunks across files so no single file holds the queue
+    vector<IoRequest> ordered;
+    for (size_t round = 0; round < maxChunks; round++) {
+        for (size_t i = 0; i < perFile.size(); i++) {
+            if (round < perFile[i].size()) ordered.push_back(perFile[i][round]);
+        }
+    }
+
+    bool ok = runIoBatch(ordered, false);
+    for (size_t i = 0; i < fds.size(); i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+    return ok;
+}
+#endif
+
+bool loadFiles(vector<FileLoad>& files) {
+    // Load every file of the batch completely; missing files load as empty with exists = false
+#ifdef _WIN32
+    // One file per pool task
+    atomic<bool> ok(true);
+    runParallel(files.size(), [&](size_t i) {
+        ifstream file(files[i].filename, ios::binary | ios::ate);
+        files[i].exists = (bool)file;
+        files[i].data.clear();
+        if (!file) return;
+        streamsize size = file.tellg();
+        file.seekg(0);
+        files[i].data.resize((size_t)size);
+        if (size > 0 && !file.read(files[i].data.data(), size)) ok = false;
+        file.close();
+    });
+    return ok;
+#else
+    return loadFilesWith(files, vector<IoRequest>());
+#endif
+}
+
+bool openDataWriter(DataWriter& out, const char* filename) {
+    // Create (or truncate) a file for writeData()
+#ifdef _WIN32
+    out.file.open(filename, ios::binary | ios::trunc);
+    out.ok = out.file.is_open();
+#else
+    out.fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    out.offset = 0;
+    out.ok = out.fd >= 0;
+#endif
+    return out.ok;
+}
+
+bool writeData(DataWriter& out, const char* data, size_t size) {
+    // Append one buffer as a batch of IO_CHUNK_SIZE writes, in flight together
+    if (!out.ok || size == 0) return out.ok;
+#ifdef _WIN32
+    out.file.write(data, (streamsize)size);
+    out.ok = (bool)out.file;
+#else
+    vector<IoRequest> reqs;
+    addChunks(reqs, out.fd, const_cast<char*>(data), size, out.offset);
+    out.ok = runIoBatch(reqs, true);
+    out.offset += (long long)size;
+#endif
+    return out.ok;
+}
+
+bool closeDataWriter(DataWriter& out) {
+    // True if the file was opened and every write went through
+#ifdef _WIN32
+    if (out.file.is_open()) out.file.close();
+    out.ok = out.ok && (bool)out.file;
+#else
+    if (out.fd >= 0) close(out.fd);
+    out.fd = -1;
+#endif
+    return out.ok;
+}
+
+bool writeFileData(const char* filename, const char* data, size_t size) {
+    // Write the whole buffer as one batch of large chunked writes (truncating the file)
+    DataWriter out;
+    if (openDataWriter(out, filename)) writeData(out, data, size);
+    return closeDataWriter(out);
+}
+
+template<typename T>
+bool loadRecords(const char* filename, vector<T>& records) {
+    // Load all whole records of a file; returns false if the file doesn't exist
+    vector<FileLoad> files(1);
+    files[0].filename = filename;
+    loadFiles(files);
+    records.clear();
+    if (!files[0].exists) return false;
+    size_t count = files[0].data.size() / sizeof(T);  // ignore a trailing partial record
+    records.resize(count);
+    if (count > 0) memcpy(static_cast<void*>(records.data()), files[0].data.data(), count * sizeof(T));
+    return true;
+}
+
+template<typename T>
+bool appendRecord(const char* filename, const T& record) {
+    // Append one record under the table's writer lock, so it can't land in a generation
+    // that a concurrent rewrite is about to replace
+    int lock = lockTable(filename);
+    long long sizeBefore = -1;
+    unsigned long long inoBefore = 0;
+    dataIdentity(filename, sizeBefore, inoBefore);
+    ofstream file(filename, ios::binary | ios::app);
+    file.write(static_cast<const char*>(static_cast<const void*>(&record)), sizeof(T));
+    file.close();
+    if (file) filterAppend(filename, sizeBefore, inoBefore, record);
+    unlockTable(lock);
+    return (bool)file;
+}
+
+// Snapshot and locking function definitions
+// Data files are never modified in place: records are only appended, and rewrites publish a
+// whole new generation with an atomic rename. A reader pins the generation it opened (the open
+// file keeps the old inode alive) and reads up to the size it saw, so reads take no locks and
+// never see a missing or half-written file. Writers serialise per file through a lock file.
+
+void tempFileName(const char* filename, char* out, size_t outSize) {
+    // Private temp name per writer process, so concurrent writers never share a temp file
+#ifdef _WIN32
+    snprintf(out, outSize, "%s.tmp", filename);
+#else
+    snprintf(out, outSize, "%s.%d.tmp", filename, (int)getpid());
+#endif
+}
+
+bool publishFile(const char* tempName, const char* filename) {
+#ifdef _WIN32
+    // Swap in the new generation in one step, so no reader finds the file missing. A reader
+    // with the old one open blocks the replace, so wait a little for it to finish its pass.
+    for (int attempt = 0; attempt < PUBLISH_RETRIES; attempt++) {
+        if (MoveFileExA(tempName, filename, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) return true;
+        DWORD error = GetLastError();
+        if (error != ERROR_ACCESS_DENIED && error != ERROR_SHARING_VIOLATION) break;
+        Sleep(PUBLISH_RETRY_MS);
+    }
+    remove(tempName);
+    return false;
+#else
+    // Make the new generation durable before it becomes visible
+    int fd = open(tempName, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    if (rename(tempName, filename) != 0) {
+        remove(tempName);
+        return false;
+    }
+    return true;
+#endif
+}
+
+#ifdef _WIN32
+bool lockFileByte(int fd, bool exclusive, bool wait) {
+    // LockFileEx on the first byte of a lock file stands in for flock()
+    OVERLAPPED range;
+    memset(&range, 0, sizeof(range));
+    DWORD flags = (exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0) | (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY);
+    return LockFileEx((HANDLE)_get_osfhandle(fd), flags, 0, 1, 0, &range) != 0;
+}
+
+void unlockFileByte(int fd) {
+    OVERLAPPED range;
+    memset(&range, 0, sizeof(range));
+    UnlockFileEx((HANDLE)_get_osfhandle(fd), 0, 1, 0, &range);
+}
+#endif
+
+int openLock(const char* lockName, bool wait) {
+#ifdef _WIN32
+    int fd = _open(lockName, _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0) return -1;
+    if (!lockFileByte(fd, true, wait)) {
+        _close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    int fd = open(lockName, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return -1;
+    while (flock(fd, wait ? LOCK_EX : LOCK_EX | LOCK_NB) != 0) {
+        if (errno != EINTR) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+#endif
+}
+
+int lockTable(const char* filename) {
+    // Writer lock for one data file: held for appends and for whole read-modify-rewrite passes
+    char lockName[80];
+    snprintf(lockName, sizeof(lockName), "%s.lock", filename);
+    return openLock(lockName, true);
+}
+
+int tryLockTable(const char* filename) {
+    // As lockTable(), but -1 at once if another writer holds it
+    char lockName[80];
+    snprintf(lockName, sizeof(lockName), "%s.lock", filename);
+    return openLock(lockName, false);
+}
+
+int lockIDs(const char* baseFile) {
+    // Serialises "generate unique ID, then append" for a table; take it before lockTable()
+    char lockName[80];
+    snprintf(lockName, sizeof(lockName), "%s.idlock", baseFile);
+    return openLock(lockName, true);
+}
+
+int lockEventSeats(int eventID) {
+    // Serialises one event's duplicate checks, seat allocation and registrations, so bookings
+    // for different events don't wait on each other; take it before lockTable()
+    char name[64];
+    seatMapFileName(eventID, name, sizeof(name));
+    return lockTable(name);
+}
+
+void unlockTable(int lockFd) {
+    if (lockFd < 0) return;
+#ifdef _WIN32
+    unlockFileByte(lockFd);  // explicitly: Windows may release a closed handle's locks late
+    _close(lockFd);
+#else
+    close(lockFd);  // closing the descriptor releases the flock
+#endif
+}
+
+void holdProcessLock() {
+    // Shared hold for the life of the process, so migration can tell when no other backend
+    // (a resident server, a one-shot call, a load generator client) could be using the files
+#ifdef _WIN32
+    processLockFd = _open(PROCESS_LOCK, _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (processLockFd < 0) return;
+    lockFileByte(processLockFd, false, true);
+#else
+    processLockFd = open(PROCESS_LOCK, O_RDWR | O_CREAT, 0644);
+    if (processLockFd < 0) return;
+    while (flock(processLockFd, LOCK_SH) != 0 && errno == EINTR) {}
+#endif
+}
+
+bool lockOutOtherProcesses() {
+    // Upgrade to an exclusive hold; false at once if any other backend process is running.
+    // Processes started meanwhile wait in holdProcessLock() until letOtherProcessesIn().
+    if (processLockFd < 0) return false;
+#ifdef _WIN32
+    // LockFileEx can't convert a hold, so drop the shared one and try for the exclusive
+    unlockFileByte(processLockFd);
+    if (lockFileByte(processLockFd, true, false)) return true;
+    lockFileByte(processLockFd, false, true);
+    return false;
+#else
+    if (flock(processLockFd, LOCK_EX | LOCK_NB) == 0) return true;
+    while (flock(processLockFd, LOCK_SH) != 0 && errno == EINTR) {}  // a failed upgrade can drop the shared hold
+    return false;
+#endif
+}
+
+void letOtherProcessesIn() {
+    if (processLockFd < 0) return;
+#ifdef _WIN32
+    unlockFileByte(processLockFd);
+    lockFileByte(processLockFd, false, true);
+#else
+    flock(processLockFd, LOCK_SH);
+#endif
+}
+
+void evictFile(const char* filename) {
+    // Drop a file's cached pages so the next read misses this machine's page cache (best effort
+    // without root drop_caches). Under a VM the host may still cache the disk, so reads stay warm.
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+#endif
+}
+
+void ioBenchmark() {
+    // Compare record-at-a-time ifstream scans against batched loadFiles() over every .dat file
+    int iterations;
+    if (!nextInt(iterations) || iterations <= 0) iterations = 5;
+
+    const char* names[] = { ORG_FILE, CUST_FILE, REG_FILE, STAFF_FILE, VENDOR_FILE };
+    const size_t recordSizes[] = { sizeof(Organiser), sizeof(Customer), sizeof(Registration), sizeof(Staff), sizeof(Vendor) };
+    const int fileCount = 5;
+
+    double legacyMs = 0, chunkedMs = 0, batchedMs = 0;
+    size_t totalBytes = 0;
+    for (int it = 0; it < iterations; it++) {
+        for (int f = 0; f < fileCount; f++) evictFile(names[f]);
+        auto start = chrono::steady_clock::now();
+        size_t bytes = 0;
+        char record[256];
+        for (int f = 0; f < fileCount; f++) {
+            ifstream file(names[f], ios::binary);
+            while (file.read(record, recordSizes[f])) bytes += recordSizes[f];
+        }
+        legacyMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        totalBytes = bytes;
+
+        // What operations run today: scanFiles() windows, each read as one batch like loadFiles()
+        for (int f = 0; f < fileCount; f++) evictFile(names[f]);
+        start = chrono::steady_clock::now();
+        for (int f = 0; f < fileCount; f++) {
+            scanFiles(vector<string>(1, names[f]), recordSizes[f], [](const char*, size_t) { return true; });
+        }
+        chunkedMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        for (int f = 0; f < fileCount; f++) evictFile(names[f]);
+        start = chrono::steady_clock::now();
+        vector<FileLoad> files(fileCount);
+        for (int f = 0; f < fileCount; f++) files[f].filename = names[f];
+        loadFiles(files);
+        batchedMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+#ifdef EMS_IO_URING
+    const char* backend = "io_uring (pread fallback if unavailable)";
+#elif defined(_WIN32)
+    const char* backend = "ifstream bulk read";
+#else
+    const char* backend = "pread";
+#endif
+    cout << "IO Benchmark: " << iterations << " passes over " << totalBytes << " bytes, page cache dropped before each" << "\n";
+    cout << "Legacy record scan: " << legacyMs / iterations << " ms/pass" << "\n";
+    cout << "Chunked scan: " << chunkedMs / iterations << " ms/pass" << "\n";
+    cout << "Batched load (" << backend << "): " << batchedMs / iterations << " ms/pass" << "\n";
+}
+
+void loadBenchmark() {
+    // Scans (page cache dropped first) of every table a multi-table operation reads, through scanFiles() as the
+    // operations read them: one file after another on one thread, against one scan of all of
+    // them on the pool, against the largest file alone (the target). Then the registration
+    // join's load (customers.dat in the first batch of the registration scan), and the customer
+    // ID index built by one thread against the pool.
+    int iterations;
+    if (!nextInt(iterations) || iterations <= 0) iterations = 5;
+    
+    vector<string> names;
+    names.push_back(ORG_FILE);
+    names.push_back(CUST_FILE);
+    if (!isShardedMode()) {
+        names.push_back(REG_FILE);
+        names.push_back(STAFF_FILE);
+        names.push_back(VENDOR_FILE);
+    } else {
+        vector<ShardEntry> shards;
+        loadShardManifest(shards);
+        char path[64];
+        for (size_t i = 0; i < shards.size(); i++) {
+            shardFileName(shards[i].baseFile, shards[i].eventID, path, sizeof(path));
+            names.push_back(path);
+        }
+    }
+    size_t totalBytes = 0, largest = 0;
+    long long largestSize = -1;
+    for (size_t f = 0; f < names.size(); f++) {
+        long long size;
+        unsigned long long ino;
+        if (!dataIdentity(names[f].c_str(), size, ino)) continue;
+        totalBytes += (size_t)size;
+        if (size > largestSize) {
+            largestSize = size;
+            largest = f;
+        }
+    }
+    function<bool(const char*, size_t)> ignore = [](const char*, size_t) { return true; };
+    
+    double serialMs = 0, parallelMs = 0, largestMs = 0, joinMs = 0, serialIndexMs = 0, parallelIndexMs = 0;
+    vector<FileLoad> customers(1);
+    customers[0].filename = CUST_FILE;
+    for (int it = 0; it < iterations; it++) {
+        for (size_t f = 0; f < names.size(); f++) evictFile(names[f].c_str());
+        poolDisabled = true;
+        auto start = chrono::steady_clock::now();
+        for (size_t f = 0; f < names.size(); f++) scanFiles(vector<string>(1, names[f]), 1, ignore);
+        serialMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        poolDisabled = false;
+        
+        for (size_t f = 0; f < names.size(); f++) evictFile(names[f].c_str());
+        start = chrono::steady_clock::now();
+        scanFiles(names, 1, ignore);
+        parallelMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        
+        evictFile(names[largest].c_str());
+        start = chrono::steady_clock::now();
+        scanFiles(vector<string>(1, names[largest]), 1, ignore);
+        largestMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        
+        evictFile(CUST_FILE);
+        evictFile(REG_FILE);
+        start = chrono::steady_clock::now();
+        scanFilesLoading(vector<string>(1, REG_FILE), sizeof(Registration), customers, ignore);
+        joinMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        
+        RecordIndex index;
+        size_t custCount = customers[0].data.size() / sizeof(Customer);
+        poolDisabled = true;
+        start = chrono::steady_clock::now();
+        buildRecordIndex(customers[0].data.data(), sizeof(Customer), custCount, offsetof(Customer, ID), index);
+        serialIndexMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        poolDisabled = false;
+        start = chrono::steady_clock::now();
+        buildRecordIndex(customers[0].data.data(), sizeof(Customer), custCount, offsetof(Customer, ID), index);
+        parallelIndexMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    
+    cout << "Load Benchmark: " << iterations << " passes over " << totalBytes << " bytes in "
+         << names.size() << " files, " << poolThreads() << " threads, page cache dropped before each" << "\n";
+    cout << "Serial Scan: " << serialMs / iterations << " ms/pass" << "\n";
+    cout << "Parallel Scan: " << parallelMs / iterations << " ms/pass" << "\n";
+    cout << "Largest File Alone: " << largestMs / iterations << " ms/pass (" << names[largest] << ")" << "\n";
+    cout << "Join Load: " << joinMs / iterations << " ms/pass (" << CUST_FILE << " with " << REG_FILE << ")" << "\n";
+    cout << "Customer Index: " << customers[0].data.size() / sizeof(Customer) << " records, serial "
+         << serialIndexMs / iterations << " ms/pass, parallel " << parallelIndexMs / iterations << " ms/pass" << "\n";
+}
+
+// Memory budget function definitions
+// An operation never holds more than the memory budget (EMS_MEMORY_MB, default 256 MB). Tables
+// are scanned and rewritten a chunk at a time, so their size doesn't matter. A join indexes
+// customers.dat in memory only while it fits; otherwise it becomes a Grace hash join through
+// spill files next to the data, which are removed when the join ends.
+
+size_t memoryBudget() {
+    if (memoryBudgetCache == 0) {
+        const char* setting = getenv("EMS_MEMORY_MB");
+        long long mb = setting ? atoll(setting) : 0;
+        memoryBudgetCache = (size_t)(mb > 0 ? mb : (long long)DEFAULT_MEMORY_MB) << 20;
+    }
+    return memoryBudgetCache;
+}
+
+size_t scanChunkRecords(size_t recordSize) {
+    size_t records = memoryBudget() / SCAN_BUDGET_SHARE / recordSize;
+    return records > 0 ? records : 1;
+}
+
+bool fitsInMemory(long long bytes) {
+    // Whether a table can be loaded and indexed whole in half the budget
+    return bytes * INDEX_OVERHEAD <= (long long)(memoryBudget() / 2);
+}
+
+bool scanFiles(const vector<string>& paths, size_t recordSize, const function<bool(const char*, size_t)>& visit) {
+    vector<FileLoad> none;
+    return scanFilesLoading(paths, recordSize, none, visit);
+}
+
+bool scanFilesLoading(const vector<string>& paths, size_t recordSize, vector<FileLoad>& alongside, const function<bool(const char*, size_t)>& visit) {
+    // Visit the whole records of several files in order, a window of up to one chunk at a time.
+    // Small files share a window and a big one is spread over several. Each window is read as
+    // one batch of IO_CHUNK_SIZE requests (see loadFiles), so a big file is read with the queue
+    // full and across the pool; the files in alongside are loaded whole in the first batch.
+    // A file is read up to the size it had when the scan reached it, from the generation it
+    // opened then. visit returns false to stop early. Returns false if none of the files
+    // exists or a read failed.
+    size_t chunkBytes = scanChunkRecords(recordSize) * recordSize;
+    vector<long long> sizes(paths.size(), -1);  // bytes of whole records, once the file is open
+#ifdef _WIN32
+    vector<ifstream> files(paths.size());
+#else
+    vector<int> fds(paths.size(), -1);
+#endif
+    vector<char> window;
+    vector<ScanPiece> pieces;
+    size_t next = 0, closed = 0;  // file being read, and files before it not yet closed
+    long long offset = 0;         // next byte to read from it
+    bool exists = false, failed = false, stopped = false, loaded = alongside.empty();
+    while (!stopped && !failed) {
+        // Fill a window from as many files as fit
+        pieces.clear();
+        size_t used = 0;
+        while (next < paths.size() && chunkBytes - used >= recordSize) {
+            if (sizes[next] < 0) {
+                long long size = -1;
+#ifdef _WIN32
+                files[next].open(paths[next].c_str(), ios::binary | ios::ate);
+                if (files[next]) size = (long long)files[next].tellg();
+#else
+                fds[next] = open(paths[next].c_str(), O_RDONLY);
+                struct stat st;
+                if (fds[next] >= 0 && fstat(fds[next], &st) == 0) size = (long long)st.st_size;
+#ifdef POSIX_FADV_SEQUENTIAL
+                if (size > 0) posix_fadvise(fds[next], 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#endif
+                if (size < 0) {
+                    next++;
+                    continue;
+                }
+                exists = true;
+                sizes[next] = size - size % (long long)recordSize;  // ignore a trailing partial record
+            }
+            size_t take = (size_t)min(sizes[next] - offset, (long long)(chunkBytes - used));
+            take -= take % recordSize;
+            if (take > 0) {
+                ScanPiece piece = { next, offset, take, used };
+                pieces.push_back(piece);
+                used += take;
+                offset += (long long)take;
+            }
+            if (offset == sizes[next]) {
+                next++;
+                offset = 0;
+            }
+        }
+        if (pieces.empty() && loaded) break;
+        
+        if (window.size() < used) window.resize(used);
+#ifdef _WIN32
+        if (!loaded && !loadFiles(alongside)) failed = true;
+        for (size_t i = 0; i < pieces.size() && !failed; i++) {
+            ifstream& file = files[pieces[i].file];
+            file.seekg(pieces[i].offset);
+            if (!file.read(window.data() + pieces[i].position, (streamsize)pieces[i].length)) failed = true;
+        }
+#else
+        vector<IoRequest> reqs;
+        for (size_t i = 0; i < pieces.size(); i++) {
+            addChunks(reqs, fds[pieces[i].file], window.data() + pieces[i].position, pieces[i].length, pieces[i].offset);
+        }
+        if (!(loaded ? runIoBatch(reqs, false) : loadFilesWith(alongside, reqs))) failed = true;
+#endif
+        loaded = true;
+        for (size_t i = 0; i < pieces.size() && !stopped && !failed; i++) {
+            if (!visit(window.data() + pieces[i].position, pieces[i].length / recordSize)) stopped = true;
+        }
+        
+        // Files the scan has moved past are done with
+        for (; closed < next; closed++) {
+#ifdef _WIN32
+            if (files[closed].is_open()) files[closed].close();
+#else
+            if (fds[closed] >= 0) close(fds[closed]);
+            fds[closed] = -1;
+#endif
+        }
+    }
+#ifndef _WIN32
+    for (size_t f = closed; f < fds.size(); f++) {
+        if (fds[f] >= 0) close(fds[f]);
+    }
+#endif
+    return exists && !failed;
+}
+
+template<typename T>
+bool scanRecords(const char* filename, const function<bool(const T*, size_t)>& visit) {
+    // scanFiles() over one file of T records
+    return scanFiles(vector<string>(1, filename), sizeof(T), [&](const char* data, size_t count) {
+        return visit(static_cast<const T*>(static_cast<const void*>(data)), count);
+    });
+}
+
+template<typename T>
+bool scanRecordsLoading(const char* filename, vector<FileLoad>& alongside, const function<bool(const T*, size_t)>& visit) {
+    // scanFilesLoading() over one file of T records
+    return scanFilesLoading(vector<string>(1, filename), sizeof(T), alongside, [&](const char* data, size_t count) {
+        return visit(static_cast<const T*>(static_cast<const void*>(data)), count);
+    });
+}
+
+bool copyFilePrefix(const char* filename, DataWriter& out, long long bytes) {
+    // Copy the first bytes of a file to out, a scan window at a time
+    if (bytes <= 0) return out.ok;
+    scanFiles(vector<string>(1, filename), 1, [&](const char* data, size_t count) {
+        size_t n = (size_t)min((long long)count, bytes);
+        writeData(out, data, n);
+        bytes -= (long long)n;
+        return bytes > 0 && out.ok;
+    });
+    return bytes == 0 && out.ok;
+}
+
+template<typename T>
+bool rewriteRecords(const char* filename, const function<RecordEdit(T&)>& edit, size_t& edits) {
+    // Stream a data file through edit() into a new generation, published only if some record was
+    // changed or dropped (edits counts them, and is 0 again if the new generation couldn't be
+    // published). Nothing is written before the first edit, so a miss costs one read. Caller must
+    // hold lockTable(filename), which keeps the file unchanged.
+    edits = 0;
+    char tempName[80];
+    tempFileName(filename, tempName, sizeof(tempName));
+    DataWriter out;
+    bool opened = false;
+    long long scanned = 0;
+    vector<T> kept;
+    bool read = scanRecords<T>(filename, [&](const T* records, size_t count) {
+        kept.clear();
+        for (size_t i = 0; i < count; i++) {
+            T record = records[i];
+            RecordEdit result = edit(record);
+            if (result != KEEP_RECORD) edits++;
+            if (result != DROP_RECORD) kept.push_back(record);
+        }
+        if (edits > 0 && !opened) {
+            // First edit: the chunks before this one are copied over unchanged
+            opened = true;
+            if (openDataWriter(out, tempName)) copyFilePrefix(filename, out, scanned * (long long)sizeof(T));
+        }
+        if (opened) writeData(out, static_cast<const char*>(static_cast<const void*>(kept.data())), kept.size() * sizeof(T));
+        scanned += count;
+        return !opened || out.ok;
+    });
+    if (edits == 0) return read;
+    closeDataWriter(out);
+    if (!read || !out.ok) {
+        remove(tempName);
+        edits = 0;
+        return false;
+    }
+    if (!publishFile(tempName, filename)) {
+        edits = 0;
+        return false;
+    }
+    invalidateFilter(filename);
+    return true;
+}
+
+void spillFileName(const char* tag, unsigned level, size_t part, char* out, size_t outSize) {
+    // Private spill file name per process and partition level, like tempFileName()
+#ifdef _WIN32
+    snprintf(out, outSize, "spill_%s%u_%u.tmp", tag, level, (unsigned)part);
+#else
+    snprintf(out, outSize, "spill_%d_%s%u_%u.tmp", (int)getpid(), tag, level, (unsigned)part);
+#endif
+}
+
+size_t spillPartition(int customerID, unsigned level, size_t parts) {
+    // A customer ID's partition when a join splits at this level. Each level hashes with its own
+    // seed, so the IDs of a partition that is split again spread over all the new partitions.
+    unsigned long long hash = ((unsigned long long)level << 32 | (unsigned)customerID) * 0x9e3779b97f4a7c15ULL;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return (size_t)(hash % parts);
+}
+
+bool joinRegistrations(const char* regFile, int eventID, const function<void(const Registration&, const Customer*)>& visit) {
+    // Visit an event's registrations in file order, each with its customer (NULL if unknown).
+    // Returns false if the registration file can't be read.
+    long long custSize = 0;
+    unsigned long long custIno;
+    if (!dataIdentity(CUST_FILE, custSize, custIno)) custSize = 0;
+    if (!fitsInMemory(custSize)) return spillJoinRegistrations(regFile, eventID, custSize, visit);
+    
+    // Customers are loaded in the same batch as the first registrations, then indexed by ID once
+    // instead of rescanning customers.dat for every registration
+    vector<FileLoad> files(1);
+    files[0].filename = CUST_FILE;
+    const Customer* customers = NULL;
+    RecordIndex custByID;
+    bool indexed = false;
+    return scanRecordsLoading<Registration>(regFile, files, [&](const Registration* regs, size_t count) {
+        if (!indexed) {
+            indexed = true;
+            customers = static_cast<const Customer*>(static_cast<const void*>(files[0].data.data()));
+            buildRecordIndex(files[0].data.data(), sizeof(Customer), files[0].data.size() / sizeof(Customer),
+                             offsetof(Customer, ID), custByID);
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (regs[i].eventID != eventID) continue;
+            long long found = findIndexedRecord(custByID, regs[i].customerID);
+            visit(regs[i], found >= 0 ? &customers[found] : NULL);
+        }
+        return true;
+    });
+}
+
+bool spillJoinRegistrations(const char* regFile, int eventID, long long custSize, const function<void(const Registration&, const Customer*)>& visit) {
+    // Grace hash join: the event's registrations are numbered into a spill file, then joined to
+    // customers.dat partition by partition (see joinSpillPartition)
+    char regName[64];
+    spillFileName("reg", 0, 0, regName, sizeof(regName));
+    ofstream regOut(regName, ios::binary | ios::trunc);
+    long long seq = 0;
+    bool exists = scanRecords<Registration>(regFile, [&](const Registration* regs, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            if (regs[i].eventID != eventID) continue;
+            SpilledRegistration spilled;
+            spilled.seq = seq++;
+            spilled.reg = regs[i];
+            regOut.write(static_cast<const char*>(static_cast<const void*>(&spilled)), sizeof(spilled));
+        }
+        return (bool)regOut;
+    });
+    regOut.close();
+    bool ok = regOut && (!exists || joinSpillPartition(CUST_FILE, custSize, regName, 0, [&](const JoinedRegistration& row) {
+        visit(row.reg, row.found ? &row.cust : NULL);
+    }));
+    remove(regName);
+    if (!ok) cerr << "Join failed: cannot write spill files" << endl;
+    return ok && exists;
+}
+
+bool joinSpillPartition(const char* custFile, long long custSize, const char* regFile, unsigned level, const function<void(const JoinedRegistration&)>& emit) {
+    // Join spilled registrations to the customers of the same partition, emitting rows in
+    // registration order. Customers that fit the budget are indexed in memory. Otherwise both
+    // sides are split on customer ID into partitions small enough to index, each partition is
+    // joined on its own (split again if its IDs were unlucky, up to MAX_SPILL_DEPTH levels, after
+    // which it is indexed whatever its size), and the partition outputs are merged back on the
+    // registration's number. Returns false if a spill file couldn't be written.
+    if (fitsInMemory(custSize) || level >= MAX_SPILL_DEPTH) {
+        vector<Customer> customers;
+        loadRecords(custFile, customers);
+        RecordIndex custByID;
+        buildRecordIndex(static_cast<const char*>(static_cast<const void*>(customers.data())), sizeof(Customer),
+                         customers.size(), offsetof(Customer, ID), custByID);
+        scanRecords<SpilledRegistration>(regFile, [&](const SpilledRegistration* regs, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                JoinedRegistration row;
+                memset(&row, 0, sizeof(row));
+                row.seq = regs[i].seq;
+                row.reg = regs[i].reg;
+                long long found = findIndexedRecord(custByID, row.reg.customerID);
+                row.found = found >= 0;
+                if (row.found) row.cust = customers[found];
+                emit(row);
+            }
+            return true;
+        });
+        return true;
+    }
+    
+    size_t parts = (size_t)(custSize * INDEX_OVERHEAD / (long long)(memoryBudget() / 2)) + 1;
+    if (parts > MAX_SPILL_PARTITIONS) parts = MAX_SPILL_PARTITIONS;
+    vector<string> custParts(parts), regParts(parts), joinedParts(parts);
+    vector<long long> custSizes(parts, 0);
+    char name[64];
+    for (size_t p = 0; p < parts; p++) {
+        spillFileName("cust", level + 1, p, name, sizeof(name));
+        custParts[p] = name;
+        spillFileName("reg", level + 1, p, name, sizeof(name));
+        regParts[p] = name;
+        spillFileName("joined", level + 1, p, name, sizeof(name));
+        joinedParts[p] = name;
+    }
+    
+    bool ok = true;
+    {
+        vector<ofstream> custOut(parts), regOut(parts);
+        for (size_t p = 0; p < parts; p++) {
+            custOut[p].open(custParts[p].c_str(), ios::binary | ios::trunc);
+            regOut[p].open(regParts[p].c_str(), ios::binary | ios::trunc);
+        }
+        scanRecords<Customer>(custFile, [&](const Customer* custs, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                size_t p = spillPartition(custs[i].ID, level, parts);
+                custOut[p].write(static_cast<const char*>(static_cast<const void*>(&custs[i])), sizeof(Customer));
+                custSizes[p] += sizeof(Customer);
+            }
+            return true;
+        });
+        scanRecords<SpilledRegistration>(regFile, [&](const SpilledRegistration* regs, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                size_t p = spillPartition(regs[i].reg.customerID, level, parts);
+                regOut[p].write(static_cast<const char*>(static_cast<const void*>(&regs[i])), sizeof(SpilledRegistration));
+            }
+            return true;
+        });
+        for (size_t p = 0; p < parts; p++) {
+            custOut[p].close();
+            regOut[p].close();
+            if (!custOut[p] || !regOut[p]) ok = false;
+        }
+    }
+    
+    for (size_t p = 0; p < parts && ok; p++) {
+        ofstream joinedOut(joinedParts[p].c_str(), ios::binary | ios::trunc);
+        if (!joinSpillPartition(custParts[p].c_str(), custSizes[p], regParts[p].c_str(), level + 1, [&](const JoinedRegistration& row) {
+            joinedOut.write(static_cast<const char*>(static_cast<const void*>(&row)), sizeof(row));
+        })) {
+            ok = false;
+        }
+        joinedOut.close();
+        if (!joinedOut) ok = false;
+        remove(custParts[p].c_str());
+        remove(regParts[p].c_str());
+    }
+    
+    if (ok) {
+        vector<ifstream> joinedIn(parts);
+        vector<JoinedRegistration> heads(parts);
+        priority_queue< pair<long long, size_t>, vector< pair<long long, size_t> >, greater< pair<long long, size_t> > > next;
+        for (size_t p = 0; p < parts; p++) {
+            joinedIn[p].open(joinedParts[p].c_str(), ios::binary);
+            if (joinedIn[p].read(static_cast<char*>(static_cast<void*>(&heads[p])), sizeof(JoinedRegistration))) {
+                next.push(make_pair(heads[p].seq, p));
+            }
+        }
+        while (!next.empty()) {
+            size_t p = next.top().second;
+            next.pop();
+            emit(heads[p]);
+            if (joinedIn[p].read(static_cast<char*>(static_cast<void*>(&heads[p])), sizeof(JoinedRegistration))) {
+                next.push(make_pair(heads[p].seq, p));
+            }
+        }
+    }
+    
+    for (size_t p = 0; p < parts; p++) {
+        remove(custParts[p].c_str());
+        remove(regParts[p].c_str());
+        remove(joinedParts[p].c_str());
+    }
+    return ok;
+}
+
+// Sharded storage function definitions
+// In sharded mode (shards.manifest present) registrations, staff and vendors live in one file per
+// event, e.g. staff_e500.dat, so event-scoped reads and rewrites only touch that event's data.
+// Staff and vendor IDs are mapped to their event through an append-only <table>.ids directory.
+
+bool isShardedMode() {
+    if (shardedModeCache < 0) {  // checked once per process: only the migrating process can see it change
+        ifstream manifest(SHARD_MANIFEST);
+        shardedModeCache = manifest ? 1 : 0;
+    }
+    return shardedModeCache == 1;
+}
+
+void shardFileName(const char* baseFile, int eventID, char* out, size_t outSize) {
+    // "staff.dat" + 500 -> "staff_e500.dat"
+    size_t stem = strlen(baseFile);
+    if (stem > 4 && strcmp(baseFile + stem - 4, ".dat") == 0) stem -= 4;
+    snprintf(out, outSize, "%.*s_e%d.dat", (int)stem, baseFile, eventID);
+}
+
+void shardDirectoryName(const char* baseFile, char* out, size_t outSize) {
+    // "staff.dat" -> "staff.ids"
+    size_t stem = strlen(baseFile);
+    if (stem > 4 && strcmp(baseFile + stem - 4, ".dat") == 0) stem -= 4;
+    snprintf(out, outSize, "%.*s.ids", (int)stem, baseFile);
+}
+
+const char* eventFile(const char* baseFile, int eventID, char* buf, size_t bufSize) {
+    // File holding an event's records: its shard in sharded mode, else the global file
+    if (!isShardedMode()) return baseFile;
+    shardFileName(baseFile, eventID, buf, bufSize);
+    return buf;
+}
+
+bool loadShardManifest(vector<ShardEntry>& entries) {
+    ifstream manifest(SHARD_MANIFEST);
+    if (!manifest) return false;
+    char header[32];
+    int version = 0;
+    if (!(manifest >> header >> version) || strcmp(header, "EMS_SHARDS") != 0) return false;
+    ShardEntry entry;
+    while (manifest >> setw(sizeof(entry.baseFile)) >> entry.baseFile >> entry.eventID) {
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+bool findShardedID(const char* baseFile, int targetID, int& eventID) {
+    // Look up which event shard holds a staff/vendor ID (latest directory entry wins)
+    char dirName[64];
+    shardDirectoryName(baseFile, dirName, sizeof(dirName));
+    bool found = false;
+    scanRecords<ShardDirEntry>(dirName, [&](const ShardDirEntry* dir, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            if (dir[i].ID == targetID) {
+                eventID = dir[i].eventID;
+                found = true;
+            }
+        }
+        return true;
+    });
+    return found;
+}
+
+const char* recordFile(const char* baseFile, int recordID, char* buf, size_t bufSize) {
+    // File holding a staff/vendor record by ID; NULL if the ID is unknown in sharded mode
+    if (!isShardedMode()) return baseFile;
+    int eventID;
+    if (!findShardedID(baseFile, recordID, eventID)) return NULL;
+    shardFileName(baseFile, eventID, buf, bufSize);
+    return buf;
+}
+
+// Field accessors used to split records by event (registrations have no ID of their own)
+int recordEventID(const Registration& reg) { return reg.eventID; }
+int recordEventID(const Staff& staff) { return staff.eventID; }
+int recordEventID(const Vendor& vendor) { return vendor.eventID; }
+int recordID(const Registration&) { return -1; }
+int recordID(const Staff& staff) { return staff.ID; }
+int recordID(const Vendor& vendor) { return vendor.ID; }
+
+// Change feed table and key of a record (registrations are keyed by customer)
+ChangeTable changeTable(const Registration&) { return TABLE_REGISTRATIONS; }
+ChangeTable changeTable(const Staff&) { return TABLE_STAFF; }
+ChangeTable changeTable(const Vendor&) { return TABLE_VENDORS; }
+int changeKey(const Registration& reg) { return reg.customerID; }
+int changeKey(const Staff& staff) { return staff.ID; }
+int changeKey(const Vendor& vendor) { return vendor.ID; }
+
+template<typename T>
+bool appendEventRecord(const char* baseFile, int eventID, int recordID, const T& record) {
+    // Append to the global file, or to the event's shard (registering new shards in the manifest),
+    // and log the insert before the file's lock is released. Returns false if the write failed.
+    char path[64];
+    const char* filename = eventFile(baseFile, eventID, path, sizeof(path));
+    int lock = lockTable(filename);
+    long long sizeBefore = -1;
+    unsigned long long inoBefore = 0;
+    if (isShardedMode()) {
+        ifstream existing(filename, ios::binary);
+        if (!existing) {
+            ofstream manifest(SHARD_MANIFEST, ios::app);
+            manifest << baseFile << " " << eventID << "\n";
+            manifest.close();
+        }
+        if (recordID >= 0) {
+            char dirName[64];
+            shardDirectoryName(baseFile, dirName, sizeof(dirName));
+            ShardDirEntry entry;
+            entry.ID = recordID;
+            entry.eventID = eventID;
+            dataIdentity(dirName, sizeBefore, inoBefore);
+            ofstream dir(dirName, ios::binary | ios::app);
+            dir.write(static_cast<char*>(static_cast<void*>(&entry)), sizeof(ShardDirEntry));
+            dir.close();
+            if (dir) filterAppend(dirName, sizeBefore, inoBefore, entry);  // the caller's ID lock covers <table>.ids
+        }
+    }
+    sizeBefore = -1;
+    dataIdentity(filename, sizeBefore, inoBefore);
+    ofstream file(filename, ios::binary | ios::app);
+    file.write(static_cast<const char*>(static_cast<const void*>(&record)), sizeof(T));
+    file.close();
+    if (file) {
+        filterAppend(filename, sizeBefore, inoBefore, record);
+        logChange(changeTable(record), CHANGE_INSERT, eventID, changeKey(record), &record, sizeof(T));
+    }
+    unlockTable(lock);
+    return (bool)file;
+}
+
+// Split one global file into per-event shards and return the event IDs written. The file is
+// read a chunk at a time and each chunk's records are appended to their shards, so memory stays
+// at about one chunk whatever the size of the table. Returns false if a read or write failed.
+template<typename T>
+bool writeShards(const char* baseFile, size_t& count, vector<int>& eventIDs) {
+    count = 0;
+    long long size;
+    unsigned long long ino;
+    if (!dataIdentity(baseFile, size, ino)) return true;  // nothing to migrate
+
+    unordered_map<int, vector<T> > byEvent;   // this chunk's records, by event
+    unordered_map<int, bool> started;         // shards created (truncated) by this migration
+    vector<int> chunkEvents;
+    vector<ShardDirEntry> dir;
+    bool dirStarted = false;
+    char path[64];
+    bool ok = true;
+    bool read = scanRecords<T>(baseFile, [&](const T* records, size_t chunkCount) {
+        byEvent.clear();
+        chunkEvents.clear();
+        dir.clear();
+        for (size_t i = 0; i < chunkCount; i++) {
+            int eventID = recordEventID(records[i]);
+            if (byEvent.find(eventID) == byEvent.end()) chunkEvents.push_back(eventID);
+            byEvent[eventID].push_back(records[i]);
+            if (recordID(records[i]) >= 0) {
+                ShardDirEntry entry;
+                entry.ID = recordID(records[i]);
+                entry.eventID = eventID;
+                dir.push_back(entry);
+            }
+        }
+        count += chunkCount;
+
+        for (size_t i = 0; i < chunkEvents.size() && ok; i++) {
+            const vector<T>& shard = byEvent[chunkEvents[i]];
+            bool first = !started[chunkEvents[i]];
+            if (first) eventIDs.push_back(chunkEvents[i]);
+            started[chunkEvents[i]] = true;
+            shardFileName(baseFile, chunkEvents[i], path, sizeof(path));
+            ofstream file(path, ios::binary | (first ? ios::trunc : ios::app));
+            file.write(static_cast<const char*>(static_cast<const void*>(shard.data())), shard.size() * sizeof(T));
+            file.close();
+            ok = (bool)file;
+        }
+        if (!dir.empty() && ok) {
+            shardDirectoryName(baseFile, path, sizeof(path));
+            ofstream file(path, ios::binary | (dirStarted ? ios::app : ios::trunc));
+            dirStarted = true;
+            file.write(static_cast<const char*>(static_cast<const void*>(dir.data())), dir.size() * sizeof(ShardDirEntry));
+            file.close();
+            ok = (bool)file;
+        }
+        return ok;
+    });
+    return read && ok;
+}
+
+void migrateToShards() {
+    // Convert registrations.dat, staff.dat and vendors.dat into per-event shard files.
+    // Offline maintenance: refused while any other backend process (e.g. the app's resident
+    // server) is running, since it would keep using the global files it has already chosen.
+    if (isShardedMode()) {
+        cout << "Already using sharded storage" << "\n";
+        return;
+    }
+    if (!lockOutOtherProcesses()) {
+        cout << "Migration refused: another backend process is running; stop the app first" << "\n";
+        return;
+    }
+
+    vector<int> regEvents, staffEvents, vendorEvents;
+    size_t regCount, staffCount, vendorCount;
+    if (!writeShards<Registration>(REG_FILE, regCount, regEvents) ||
+        !writeShards<Staff>(STAFF_FILE, staffCount, staffEvents) ||
+        !writeShards<Vendor>(VENDOR_FILE, vendorCount, vendorEvents)) {
+        letOtherProcessesIn();
+        cout << "Migration failed: could not read data files" << "\n";
+        return;
+    }
+
+    // The manifest is written last: until it exists the global files stay authoritative,
+    // so an interrupted migration can simply be run again
+    char tempName[80];
+    tempFileName(SHARD_MANIFEST, tempName, sizeof(tempName));
+    ofstream manifest(tempName);
+    manifest << "EMS_SHARDS 1\n";
+    for (size_t i = 0; i < regEvents.size(); i++) manifest << REG_FILE << " " << regEvents[i] << "\n";
+    for (size_t i = 0; i < staffEvents.size(); i++) manifest << STAFF_FILE << " " << staffEvents[i] << "\n";
+    for (size_t i = 0; i < vendorEvents.size(); i++) manifest << VENDOR_FILE << " " << vendorEvents[i] << "\n";
+    manifest.close();
+    if (!manifest || !publishFile(tempName, SHARD_MANIFEST)) {
+        remove(tempName);
+        letOtherProcessesIn();
+        cout << "Migration failed: could not write manifest" << "\n";
+        return;
+    }
+
+    shardedModeCache = 1;
+    const char* globalFiles[] = { REG_FILE, STAFF_FILE, VENDOR_FILE };
+    for (int i = 0; i < 3; i++) {
+        remove(globalFiles[i]);
+        invalidateFilter(globalFiles[i]);  // their .bloom files would otherwise be left behind
+    }
+    letOtherProcessesIn();
+
+    cout << "Migrated " << regCount << " registrations, " << staffCount << " staff, " << vendorCount
+         << " vendors into " << (regEvents.size() + staffEvents.size() + vendorEvents.size()) << " shards" << "\n";
+}
+
+// Bloom filter function definitions
+// Each data file gets a <stem>.bloom filter over its lookup keys (IDs, usernames, and
+// (eventID, customerID) pairs), so most "not found" checks return without reading the file.
+// A filter records the size and inode of the data it covers. Appends extend it in place under
+// the table's writer lock; any other change (a rewrite publishes a new inode) leaves it stale,
+// and a stale filter is rebuilt on the next check rather than trusted. Readers publish a rebuilt
+// filter only while holding the writer lock, so the file on disk always matches its header.
+
+void filterFileName(const char* dataFile, char* out, size_t outSize) {
+    // "staff.dat" -> "staff.bloom", "staff.ids" -> "staff.ids.bloom"
+    size_t stem = strlen(dataFile);
+    if (stem > 4 && strcmp(dataFile + stem - 4, ".dat") == 0) stem -= 4;
+    snprintf(out, outSize, "%.*s.bloom", (int)stem, dataFile);
+}
+
+bool dataIdentity(const char* filename, long long& size, unsigned long long& ino) {
+#ifdef _WIN32
+    // stat() has no inode here: use the NTFS file index, which a replace changes, mixed with the
+    // last-write time, which any rewrite in place changes
+    HANDLE handle = CreateFileA(filename, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    BY_HANDLE_FILE_INFORMATION info;
+    bool found = GetFileInformationByHandle(handle, &info) != 0;
+    CloseHandle(handle);
+    if (!found) return false;
+    size = (long long)(((unsigned long long)info.nFileSizeHigh << 32) | info.nFileSizeLow);
+    unsigned long long fileIndex = ((unsigned long long)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+    unsigned long long written = ((unsigned long long)info.ftLastWriteTime.dwHighDateTime << 32) |
+                                 info.ftLastWriteTime.dwLowDateTime;
+    ino = fileIndex ^ (written * 0x9e3779b97f4a7c15ULL);
+    return true;
+#else
+    struct stat st;
+    if (stat(filename, &st) != 0) return false;
+    size = (long long)st.st_size;
+    ino = (unsigned long long)st.st_ino;
+    return true;
+#endif
+}
+
+bool filterCovers(const BloomFilter& filter, long long size, unsigned long long ino) {
+    return filter.header.bitCount > 0 && filter.header.dataSize == size && filter.header.dataIno == ino;
+}
+
+unsigned long long hashFilterKey(FilterKeyKind kind, const void* key, size_t len) {
+    // FNV-1a over the key kind and bytes, then a 64-bit finaliser to spread the low bits
+    unsigned long long hash = 14695981039346656037ULL;
+    hash = (hash ^ (unsigned)kind) * 1099511628211ULL;
+    const unsigned char* bytes = static_cast<const unsigned char*>(key);
+    for (size_t i = 0; i < len; i++) hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+void bloomAdd(BloomFilter& filter, FilterKeyKind kind, const void* key, size_t len) {
+    unsigned long long hash = hashFilterKey(kind, key, len);
+    unsigned h1 = (unsigned)hash, h2 = (unsigned)(hash >> 32) | 1;
+    unsigned mask = filter.header.bitCount - 1;
+    for (unsigned i = 0; i < filter.header.hashCount; i++) {
+        unsigned bit = (h1 + i * h2) & mask;
+        filter.bits[bit >> 3] |= (unsigned char)(1 << (bit & 7));
+        filter.dirty.push_back(bit >> 3);
+    }
+    filter.header.keyCount++;
+}
+
+bool bloomTest(const BloomFilter& filter, FilterKeyKind kind, const void* key, size_t len) {
+    unsigned long long hash = hashFilterKey(kind, key, len);
+    unsigned h1 = (unsigned)hash, h2 = (unsigned)(hash >> 32) | 1;
+    unsigned mask = filter.header.bitCount - 1;
+    for (unsigned i = 0; i < filter.header.hashCount; i++) {
+        unsigned bit = (h1 + i * h2) & mask;
+        if (!(filter.bits[bit >> 3] & (1 << (bit & 7)))) return false;
+    }
+    return true;
+}
+
+// Lookup keys of each record type
+void addFilterKeys(BloomFilter& filter, const Organiser& org) {
+    bloomAdd(filter, KEY_ID, &org.ID, sizeof(int));
+    bloomAdd(filter, KEY_USERNAME, org.username, strnlen(org.username, sizeof(org.username)));
+}
+void addFilterKeys(BloomFilter& filter, const Customer& cust) {
+    bloomAdd(filter, KEY_ID, &cust.ID, sizeof(int));
+    bloomAdd(filter, KEY_USERNAME, cust.username, strnlen(cust.username, sizeof(cust.username)));
+}
+void addFilterKeys(BloomFilter& filter, const Staff& staff) { bloomAdd(filter, KEY_ID, &staff.ID, sizeof(int)); }
+void addFilterKeys(BloomFilter& filter, const Vendor& vendor) { bloomAdd(filter, KEY_ID, &vendor.ID, sizeof(int)); }
+void addFilterKeys(BloomFilter& filter, const ShardDirEntry& entry) { bloomAdd(filter, KEY_ID, &entry.ID, sizeof(int)); }
+void addFilterKeys(BloomFilter& filter, const Registration& reg) {
+    int pair[2] = { reg.eventID, reg.customerID };
+    bloomAdd(filter, KEY_REGISTRATION, pair, sizeof(pair));
+}
+
+template<typename T>
+bool buildFilter(const char* dataFile, BloomFilter& filter) {
+    // Rebuild from the data file; false if it is missing or changed while being read
+    long long size, sizeAfter;
+    unsigned long long ino, inoAfter;
+    if (!dataIdentity(dataFile, size, ino)) return false;
+    
+    // Sized for twice the current keys, so appends rarely force a rebuild
+    size_t recordCount = (size_t)size / sizeof(T);
+    unsigned bits = BLOOM_MIN_BITS;
+    while (bits < recordCount * BLOOM_KEYS_PER_RECORD * 2 * BLOOM_BITS_PER_KEY && bits < (1u << 31)) bits <<= 1;
+    memset(&filter.header, 0, sizeof(BloomHeader));
+    memcpy(filter.header.magic, "EMSBLOOM", 8);
+    filter.header.dataSize = size;
+    filter.header.dataIno = ino;
+    filter.header.bitCount = bits;
+    filter.header.hashCount = BLOOM_HASHES;
+    filter.bits.assign(bits / 8, 0);
+    if (!scanRecords<T>(dataFile, [&](const T* records, size_t count) {
+        for (size_t i = 0; i < count; i++) addFilterKeys(filter, records[i]);
+        return true;
+    })) return false;
+    if (!dataIdentity(dataFile, sizeAfter, inoAfter) || sizeAfter != size || inoAfter != ino) return false;
+    filter.dirty.clear();
+    return true;
+}
+
+bool readFilter(const char* dataFile, BloomFilter& filter) {
+    char name[80];
+    filterFileName(dataFile, name, sizeof(name));
+    vector<FileLoad> files(1);
+    files[0].filename = name;
+    loadFiles(files);
+    const vector<char>& data = files[0].data;
+    if (!files[0].exists || data.size() < sizeof(BloomHeader)) return false;
+    BloomHeader header;
+    memcpy(&header, data.data(), sizeof(BloomHeader));
+    unsigned bits = header.bitCount;
+    if (memcmp(header.magic, "EMSBLOOM", 8) != 0 || bits < 8 || (bits & (bits - 1)) != 0 ||
+        data.size() != sizeof(BloomHeader) + bits / 8) return false;
+    filter.header = header;
+    filter.bits.assign(data.begin() + sizeof(BloomHeader), data.end());
+    filter.dirty.clear();
+    return true;
+}
+
+void saveFilter(const char* dataFile, BloomFilter& filter) {
+    // Publish a whole new filter file; caller holds the data file's writer lock
+    char name[80], tempName[96];
+    filterFileName(dataFile, name, sizeof(name));
+    tempFileName(name, tempName, sizeof(tempName));
+    vector<char> data(sizeof(BloomHeader) + filter.bits.size());
+    memcpy(data.data(), &filter.header, sizeof(BloomHeader));
+    if (!filter.bits.empty()) memcpy(data.data() + sizeof(BloomHeader), filter.bits.data(), filter.bits.size());
+    if (!writeFileData(tempName, data.data(), data.size()) || !publishFile(tempName, name)) remove(tempName);
+    filter.dirty.clear();
+}
+
+void updateFilterFile(const char* dataFile, BloomFilter& filter, long long sizeBefore, unsigned long long inoBefore) {
+    // After appends: rewrite only the changed bytes, then the header that makes them current.
+    // Only valid if the file on disk is the one those bytes were changed from; otherwise
+    // (another process rebuilt it, or it is gone) publish the whole filter.
+    char name[80];
+    filterFileName(dataFile, name, sizeof(name));
+    fstream file(name, ios::in | ios::out | ios::binary);
+    BloomFilter disk;
+    if (!file || !file.read(static_cast<char*>(static_cast<void*>(&disk.header)), sizeof(BloomHeader)) ||
+        !filterCovers(disk, sizeBefore, inoBefore) || disk.header.bitCount != filter.header.bitCount) {
+        file.close();
+        saveFilter(dataFile, filter);
+        return;
+    }
+    sort(filter.dirty.begin(), filter.dirty.end());
+    filter.dirty.erase(unique(filter.dirty.begin(), filter.dirty.end()), filter.dirty.end());
+    for (size_t i = 0; i < filter.dirty.size(); i++) {
+        file.seekp(sizeof(BloomHeader) + filter.dirty[i]);
+        file.write(static_cast<char*>(static_cast<void*>(&filter.bits[filter.dirty[i]])), 1);
+    }
+    file.flush();
+    file.seekp(0);
+    file.write(static_cast<char*>(static_cast<void*>(&filter.header)), sizeof(BloomHeader));
+    file.close();
+    filter.dirty.clear();
+}
+
+template<typename T>
+BloomFilter* currentFilter(const char* dataFile) {
+    // Filter covering the data file as it is now, loaded or rebuilt as needed; NULL if the
+    // file doesn't exist or is changing underneath us (callers then simply scan)
+    long long size;
+    unsigned long long ino;
+    if (!dataIdentity(dataFile, size, ino)) return NULL;
+    BloomFilter& filter = filterCache[dataFile];
+    if (filterCovers(filter, size, ino)) return &filter;
+    if (readFilter(dataFile, filter) && filterCovers(filter, size, ino)) return &filter;
+    if (!buildFilter<T>(dataFile, filter)) {
+        filter.header.bitCount = 0;
+        return NULL;
+    }
+    
+    // Publish the rebuild only if no writer is busy and the data is still what we read; a
+    // filter for an older size must never replace one a writer has since extended
+    int lock = tryLockTable(dataFile);
+#ifndef _WIN32
+    if (lock >= 0)
+#endif
+    {
+        long long sizeNow;
+        unsigned long long inoNow;
+        if (dataIdentity(dataFile, sizeNow, inoNow) && filterCovers(filter, sizeNow, inoNow)) saveFilter(dataFile, filter);
+        unlockTable(lock);
+    }
+    return filterCovers(filter, size, ino) ? &filter : NULL;
+}
+
+template<typename T>
+bool filterMayContain(const char* dataFile, FilterKeyKind kind, const void* key, size_t len) {
+    // False only if the key is definitely not in the file
+    BloomFilter* filter = currentFilter<T>(dataFile);
+    if (!filter) return true;
+    filter->checks++;
+    filter->pendingMaybe = bloomTest(*filter, kind, key, len);
+    if (!filter->pendingMaybe) filter->negatives++;
+    return filter->pendingMaybe;
+}
+
+void filterScanMissed(const char* dataFile) {
+    // The scan after a "maybe" found nothing: count a false positive
+    unordered_map<string, BloomFilter>::iterator it = filterCache.find(dataFile);
+    if (it == filterCache.end() || !it->second.pendingMaybe) return;
+    it->second.falsePositives++;
+    it->second.pendingMaybe = false;
+}
+
+template<typename T>
+void filterAppend(const char* dataFile, long long sizeBefore, unsigned long long inoBefore, const T& record) {
+    // Extend the filter for one appended record; caller holds the file's writer lock.
+    // A filter that didn't cover the file before the append is left stale.
+    long long size;
+    unsigned long long ino;
+    if (!dataIdentity(dataFile, size, ino)) return;
+    BloomFilter& filter = filterCache[dataFile];
+    if (!filterCovers(filter, sizeBefore, inoBefore) &&
+        !(readFilter(dataFile, filter) && filterCovers(filter, sizeBefore, inoBefore))) return;
+    
+    if ((filter.header.keyCount + BLOOM_KEYS_PER_RECORD) * BLOOM_BITS_PER_KEY > filter.header.bitCount) {
+        // At capacity: rebuild at twice the size
+        if (buildFilter<T>(dataFile, filter)) saveFilter(dataFile, filter);
+        return;
+    }
+    addFilterKeys(filter, record);
+    filter.header.dataSize = size;
+    filter.header.dataIno = ino;
+    updateFilterFile(dataFile, filter, sizeBefore, inoBefore);
+}
+
+void invalidateFilter(const char* dataFile) {
+    // After a rewrite; the identity check would catch it too, but this frees the disk at once
+    char name[80];
+    filterFileName(dataFile, name, sizeof(name));
+    remove(name);
+    filterCache.erase(dataFile);
+}
+
+template<typename T>
+void printFilterStats(const char* dataFile) {
+    BloomFilter* filter = currentFilter<T>(dataFile);
+    if (!filter) return;
+    unsigned setBits = 0;
+    for (size_t i = 0; i < filter->bits.size(); i++) {
+        for (unsigned char byte = filter->bits[i]; byte; byte &= byte - 1) setBits++;
+    }
+    double fill = (double)setBits / filter->header.bitCount;
+    long long absent = filter->negatives + filter->falsePositives;
+    cout << "Filter: " << dataFile << " Keys: " << filter->header.keyCount
+         << " Bits: " << filter->header.bitCount << " Hashes: " << filter->header.hashCount
+         << " Fill: " << fill << " Estimated FP: " << pow(fill, (double)filter->header.hashCount)
+         << " Checks: " << filter->checks << " Negatives: " << filter->negatives
+         << " False Positives: " << filter->falsePositives
+         << " Observed FP: " << (absent > 0 ? (double)filter->falsePositives / absent : 0.0) << "\n";
+}
+
+void filterStats() {
+    // Filters of every table; check counts are for this process (the resident server's lifetime)
+    printFilterStats<Organiser>(ORG_FILE);
+    printFilterStats<Customer>(CUST_FILE);
+    if (!isShardedMode()) {
+        printFilterStats<Registration>(REG_FILE);
+        printFilterStats<Staff>(STAFF_FILE);
+        printFilterStats<Vendor>(VENDOR_FILE);
+        return;
+    }
+    char path[64];
+    shardDirectoryName(STAFF_FILE, path, sizeof(path));
+    printFilterStats<ShardDirEntry>(path);
+    shardDirectoryName(VENDOR_FILE, path, sizeof(path));
+    printFilterStats<ShardDirEntry>(path);
+    vector<ShardEntry> shards;
+    loadShardManifest(shards);
+    for (size_t i = 0; i < shards.size(); i++) {
+        if (strcmp(shards[i].baseFile, REG_FILE) != 0) continue;
+        shardFileName(REG_FILE, shards[i].eventID, path, sizeof(path));
+        printFilterStats<Registration>(path);
+    }
+}
+
+// Seat map function definitions
+// Each event with a seat count has a seats_e<ID>.dat map: one bit per seat, set while the
+// seat is free. Above the bitmap sit summary levels in memory, one bit per non-zero word
+// of the level below, so the lowest free seat is found in one word read per level (three
+// levels cover 262,144 seats). A registration's ticket number is its seat number, so
+// tickets are unique within the event and a cancellation knows which seat to release.
+// Maps change in place under the registrations ID lock; a version in the header tells
+// cached copies in resident servers when another process has changed the map.
+
+int lowestBit(unsigned long long word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+void seatMapFileName(int eventID, char* out, size_t outSize) {
+    shardFileName(SEAT_MAP_BASE, eventID, out, outSize);
+}
+
+void buildSeatSummary(SeatMap& map) {
+    // Rebuild the summary levels above levels[0]
+    map.levels.resize(1);
+    while (map.levels.back().size() > 1) {
+        const vector<unsigned long long>& below = map.levels.back();
+        vector<unsigned long long> level((below.size() + 63) / 64, 0);
+        for (size_t w = 0; w < below.size(); w++) {
+            if (below[w]) level[w / 64] |= 1ULL << (w % 64);
+        }
+        map.levels.push_back(level);
+    }
+}
+
+void initSeatMap(SeatMap& map, int eventID, int seatCount) {
+    // All seats free; the bits past the last seat stay clear so they are never handed out
+    memset(&map.header, 0, sizeof(SeatMapHeader));
+    memcpy(map.header.magic, "EMSSEATS", 8);
+    map.header.eventID = eventID;
+    map.header.seatCount = seatCount;
+    map.header.freeCount = seatCount;
+    map.ino = 0;
+    map.levels.assign(1, vector<unsigned long long>((seatCount + 63) / 64, ~0ULL));
+    if (seatCount % 64) map.levels[0].back() = (1ULL << (seatCount % 64)) - 1;
+    map.dirty.clear();
+    buildSeatSummary(map);
+}
+
+long long nextSetBit(const SeatMap& map, size_t level, size_t index) {
+    // Lowest set bit at or after index in levels[level], -1 if none; the level above
+    // skips empty words, so this reads one word per level
+    const vector<unsigned long long>& bits = map.levels[level];
+    size_t word = index / 64;
+    if (word >= bits.size()) return -1;
+    unsigned long long masked = bits[word] & (~0ULL << (index % 64));
+    if (masked) return (long long)(word * 64 + lowestBit(masked));
+    if (level + 1 == map.levels.size()) return -1;  // the top level is a single word
+    long long nextWord = nextSetBit(map, level + 1, word + 1);
+    if (nextWord < 0) return -1;
+    return nextWord * 64 + lowestBit(bits[nextWord]);
+}
+
+long long nextTakenSeat(const SeatMap& map, long long seat, long long limit) {
+    // First taken seat at or after seat; the seat count, or limit if lower, when none is found
+    // before it (the limit stops a group search from walking a long free run to its end)
+    const vector<unsigned long long>& bits = map.levels[0];
+    if (limit > map.header.seatCount) limit = map.header.seatCount;
+    size_t word = (size_t)seat / 64, lastWord = (size_t)(limit + 63) / 64;
+    if (word >= lastWord) return limit;
+    unsigned long long taken = ~bits[word] & (~0ULL << (seat % 64));
+    while (!taken && ++word < lastWord) taken = ~bits[word];
+    if (!taken) return limit;
+    long long found = (long long)(word * 64 + lowestBit(taken));
+    return found < limit ? found : limit;
+}
+
+long long findSeatBlock(const SeatMap& map, int count) {
+    // Lowest run of count adjacent free seats, -1 if there is none
+    for (long long start = nextSetBit(map, 0, 0); start >= 0; ) {
+        long long end = nextTakenSeat(map, start, start + count);
+        if (end - start >= count) return start;
+        if (end >= map.header.seatCount) return -1;
+        start = nextSetBit(map, 0, (size_t)end);
+    }
+    return -1;
+}
+
+bool seatIsFree(const SeatMap& map, long long seat) {
+    return seat >= 0 && seat < map.header.seatCount && (map.levels[0][seat / 64] >> (seat % 64) & 1);
+}
+
+void takeSeat(SeatMap& map, long long seat) {
+    // Clear the seat's bit, then each summary bit whose word just became empty
+    size_t index = (size_t)seat;
+    map.dirty.push_back(index / 64);
+    for (size_t level = 0; level < map.levels.size(); level++) {
+        unsigned long long& word = map.levels[level][index / 64];
+        word &= ~(1ULL << (index % 64));
+        if (word) break;
+        index /= 64;
+    }
+    map.header.freeCount--;
+}
+
+void releaseSeat(SeatMap& map, long long seat) {
+    // Set the seat's bit, then each summary bit whose word was empty until now
+    size_t index = (size_t)seat;
+    map.dirty.push_back(index / 64);
+    for (size_t level = 0; level < map.levels.size(); level++) {
+        unsigned long long& word = map.levels[level][index / 64];
+        bool wasEmpty = word == 0;
+        word |= 1ULL << (index % 64);
+        if (!wasEmpty) break;
+        index /= 64;
+    }
+    map.header.freeCount++;
+}
+
+void returnSeats(SeatMap& map, long long start, int count) {
+    // Undo a booking that could not be recorded. If the map can't be written back either, the
+    // cached copy is dropped so the next request reads the file as it is.
+    for (int i = 0; i < count; i++) releaseSeat(map, start + i);
+    if (!updateSeatMapFile(map)) seatMapCache.erase(map.header.eventID);
+}
+
+SeatMap* currentSeatMap(int eventID) {
+    // The event's seat map as it is on disk now, from the cache if its version still matches;
+    // NULL if the event has no seat map
+    char name[64];
+    seatMapFileName(eventID, name, sizeof(name));
+    ifstream file(name, ios::binary);
+    SeatMapHeader header;
+    long long size;
+    unsigned long long ino;
+    if (!file || !file.read(static_cast<char*>(static_cast<void*>(&header)), sizeof(SeatMapHeader)) ||
+        memcmp(header.magic, "EMSSEATS", 8) != 0 || header.seatCount < 0 || header.seatCount > MAX_EVENT_SEATS ||
+        !dataIdentity(name, size, ino)) {
+        seatMapCache.erase(eventID);
+        return NULL;
+    }
+    
+    SeatMap& map = seatMapCache[eventID];
+    if (!map.levels.empty() && map.ino == ino && map.header.version == header.version) return &map;
+    size_t words = ((size_t)header.seatCount + 63) / 64;
+    map.header = header;
+    map.ino = ino;
+    map.levels.assign(1, vector<unsigned long long>(words));
+    map.dirty.clear();
+    if (words > 0 && !file.read(static_cast<char*>(static_cast<void*>(map.levels[0].data())), words * sizeof(unsigned long long))) {
+        seatMapCache.erase(eventID);
+        return NULL;
+    }
+    buildSeatSummary(map);
+    return &map;
+}
+
+bool saveSeatMap(SeatMap& map) {
+    // Publish a whole new map file (a new map or a new seat count); caller holds lockEventSeats()
+    char name[64], tempName[80];
+    seatMapFileName(map.header.eventID, name, sizeof(name));
+    tempFileName(name, tempName, sizeof(tempName));
+    map.header.version++;
+    vector<char> data(sizeof(SeatMapHeader) + map.levels[0].size() * sizeof(unsigned long long));
+    memcpy(data.data(), &map.header, sizeof(SeatMapHeader));
+    if (!map.levels[0].empty()) {
+        memcpy(data.data() + sizeof(SeatMapHeader), map.levels[0].data(), map.levels[0].size() * sizeof(unsigned long long));
+    }
+    if (!writeFileData(tempName, data.data(), data.size()) || !publishFile(tempName, name)) {
+        remove(tempName);
+        return false;
+    }
+    long long size;
+    dataIdentity(name, size, map.ino);
+    map.dirty.clear();
+    return true;
+}
+
+bool updateSeatMapFile(SeatMap& map) {
+    // Rewrite only the bitmap words that changed, then the header with its new version
+    char name[64];
+    seatMapFileName(map.header.eventID, name, sizeof(name));
+    fstream file(name, ios::in | ios::out | ios::binary);
+    if (!file) return saveSeatMap(map);
+    sort(map.dirty.begin(), map.dirty.end());
+    map.dirty.erase(unique(map.dirty.begin(), map.dirty.end()), map.dirty.end());
+    for (size_t i = 0; i < map.dirty.size(); i++) {
+        file.seekp(sizeof(SeatMapHeader) + map.dirty[i] * sizeof(unsigned long long));
+        file.write(static_cast<char*>(static_cast<void*>(&map.levels[0][map.dirty[i]])), sizeof(unsigned long long));
+    }
+    file.flush();
+    map.header.version++;
+    file.seekp(0);
+    file.write(static_cast<char*>(static_cast<void*>(&map.header)), sizeof(SeatMapHeader));
+    file.close();
+    map.dirty.clear();
+    return (bool)file;
+}
+
+bool seatExistingRegistrations(SeatMap& map) {
+    // A new map for an event that already has registrations: keep every ticket that is already
+    // a valid, unclaimed seat, and give the rest (old random tickets) the lowest free seats
+    int eventID = map.header.eventID;
+    char path[64];
+    const char* filename = eventFile(REG_FILE, eventID, path, sizeof(path));
+    int lock = lockTable(filename);
+    
+    // First pass seats the valid tickets and notes where the others are; the rewrite then gives
+    // those records their new seats in the same order
+    vector<size_t> unseated;
+    size_t position = 0;
+    scanRecords<Registration>(filename, [&](const Registration* regs, size_t count) {
+        for (size_t i = 0; i < count; i++, position++) {
+            if (regs[i].eventID != eventID) continue;
+            long long seat = (long long)regs[i].ticketNum - 1;
+            if (seatIsFree(map, seat)) {
+                takeSeat(map, seat);
+            } else {
+                unseated.push_back(position);
+            }
+        }
+        return true;
+    });
+    if ((long long)unseated.size() > map.header.freeCount) {
+        unlockTable(lock);
+        return false;
+    }
+    vector<Registration> moved;
+    size_t next = 0, edits = 0;
+    position = 0;
+    bool replaced = unseated.empty() || rewriteRecords<Registration>(filename, [&](Registration& reg) {
+        if (next == unseated.size() || position++ != unseated[next]) return KEEP_RECORD;
+        next++;
+        long long seat = nextSetBit(map, 0, 0);
+        takeSeat(map, seat);
+        reg.ticketNum = (int)(seat + 1);
+        moved.push_back(reg);
+        return CHANGE_RECORD;
+    }, edits);
+    for (size_t i = 0; replaced && i < moved.size(); i++) {
+        logChange(TABLE_REGISTRATIONS, CHANGE_UPDATE, eventID, moved[i].customerID, &moved[i], sizeof(Registration));
+    }
+    unlockTable(lock);
+    return replaced;
+}
+
+void setEventSeats() {
+    // Create an event's seat map, or change its seat count; seats that are taken can't be removed
+    int eventID = 0, seatCount = 0;
+    nextInt(eventID);
+    nextInt(seatCount);
+    if (!requestOK()) return;
+    if (seatCount < 0 || seatCount > MAX_EVENT_SEATS) {
+        cout << "Invalid seat count (max " << MAX_EVENT_SEATS << ")" << "\n";
+        return;
+    }
+    
+    int seatLock = lockEventSeats(eventID);
+    SeatMap* existing = currentSeatMap(eventID);
+    SeatMap map;
+    initSeatMap(map, eventID, seatCount);
+    if (existing) {
+        long long blocking = nextTakenSeat(*existing, seatCount, existing->header.seatCount);
+        if (blocking < existing->header.seatCount) {
+            unlockTable(seatLock);
+            cout << "Cannot remove seats: seat " << blocking + 1 << " is taken" << "\n";
+            return;
+        }
+        map.header.version = existing->header.version;
+        long long oldCount = existing->header.seatCount;
+        for (long long seat = nextTakenSeat(*existing, 0, oldCount); seat < oldCount; seat = nextTakenSeat(*existing, seat + 1, oldCount)) {
+            takeSeat(map, seat);
+        }
+    } else if (!seatExistingRegistrations(map)) {
+        unlockTable(seatLock);
+        cout << "Cannot seat existing registrations in " << seatCount << " seats" << "\n";
+        return;
+    }
+    bool saved = saveSeatMap(map);
+    if (saved) seatMapCache[eventID] = map;
+    unlockTable(seatLock);
+    
+    if (!saved) {
+        cout << "Failed to save seat map" << "\n";
+        return;
+    }
+    cout << "Seats: " << map.header.seatCount << " Free: " << map.header.freeCount << "\n";
+}
+
+void bookGroup() {
+    // Input: event ID, fee status, group size, one customer ID per line. Every member gets a
+    // seat in one block of adjacent seats, or nobody is registered.
+    int eventID = 0, count = 0;
+    char feeStatus[10];
+    int custIDs[MAX_GROUP_SIZE];
+    nextInt(eventID);
+    nextText(feeStatus, sizeof(feeStatus));
+    nextInt(count);
+    if (count < 1 || count > MAX_GROUP_SIZE) {
+        cout << "Invalid group size (1 to " << MAX_GROUP_SIZE << ")" << "\n";
+        return;
+    }
+    for (int i = 0; i < count; i++) nextInt(custIDs[i]);
+    if (!requestOK()) return;
+    
+    int seatLock = lockEventSeats(eventID);
+    for (int i = 0; i < count; i++) {
+        int ticketNum;
+        bool repeated = find(custIDs, custIDs + i, custIDs[i]) != custIDs + i;
+        if (repeated || searchRegistration(eventID, custIDs[i], ticketNum)) {
+            unlockTable(seatLock);
+            cout << "Already Registered! CustID: " << custIDs[i] << "\n";
+            return;
+        }
+    }
+    SeatMap* seats = currentSeatMap(eventID);
+    long long start = seats ? findSeatBlock(*seats, count) : -1;
+    if (start < 0) {
+        unlockTable(seatLock);
+        if (!seats) {
+            cout << "No seat map for this event" << "\n";
+        } else {
+            cout << "Sold Out! No block of " << count << " adjacent seats left" << "\n";
+        }
+        return;
+    }
+    for (int i = 0; i < count; i++) takeSeat(*seats, start + i);
+    if (!updateSeatMapFile(*seats)) {
+        returnSeats(*seats, start, count);
+        unlockTable(seatLock);
+        cout << "Failed to save seat map" << "\n";
+        return;
+    }
+    
+    vector<Registration> regs(count);
+    int appended = 0;
+    for (int i = 0; i < count; i++) {
+        regs[i].customerID = custIDs[i];
+        regs[i].eventID = eventID;
+        regs[i].ticketNum = (int)(start + i + 1);
+        strcpy(regs[i].feeStatus, feeStatus);
+        if (!appendEventRecord(REG_FILE, eventID, -1, regs[i])) break;
+        appended++;
+    }
+    if (appended < count) {
+        // Take back the members already written; their seats are only freed if that worked
+        char path[64];
+        const char* filename = eventFile(REG_FILE, eventID, path, sizeof(path));
+        int lock = lockTable(filename);
+        size_t edits = 0;
+        bool removed = appended == 0 || rewriteRecords<Registration>(filename, [&](Registration& reg) {
+            if (reg.eventID != eventID || find(custIDs, custIDs + appended, reg.customerID) == custIDs + appended) return KEEP_RECORD;
+            return DROP_RECORD;
+        }, edits);
+        for (int i = 0; removed && i < appended; i++) {
+            logChange(TABLE_REGISTRATIONS, CHANGE_DELETE, eventID, regs[i].customerID, &regs[i], sizeof(Registration));
+        }
+        unlockTable(lock);
+        int kept = removed ? 0 : appended;
+        returnSeats(*seats, start + kept, count - kept);
+        unlockTable(seatLock);
+        cout << "Failed to save group registration" << "\n";
+        return;
+    }
+    unlockTable(seatLock);
+    
+    cout << "Group booked successfully! Seats: " << start + 1 << "-" << start + count << "\n";
+    for (int i = 0; i < count; i++) {
+        cout << "CustID: " << regs[i].customerID << " Ticket: " << regs[i].ticketNum << "\n";
+    }
+}
+
+void cancelRegistration() {
+    // Remove a customer's registration for an event and free its seat
+    int custID = 0, eventID = 0;
+    nextInt(custID);
+    nextInt(eventID);
+    if (!requestOK()) return;
+    
+    int seatLock = lockEventSeats(eventID);
+    char path[64];
+    const char* filename = eventFile(REG_FILE, eventID, path, sizeof(path));
+    int lock = lockTable(filename);
+    size_t edits = 0;
+    Registration removed = {};
+    bool replaced = rewriteRecords<Registration>(filename, [&](Registration& reg) {
+        if (edits > 0 || reg.customerID != custID || reg.eventID != eventID) return KEEP_RECORD;
+        removed = reg;
+        return DROP_RECORD;
+    }, edits) && edits > 0;
+    if (replaced) logChange(TABLE_REGISTRATIONS, CHANGE_DELETE, eventID, custID, &removed, sizeof(Registration));
+    unlockTable(lock);
+    
+    // The seat is freed only after the registration is gone, so it is never held twice
+    SeatMap* seats = replaced ? currentSeatMap(eventID) : NULL;
+    long long seat = seats ? (long long)removed.ticketNum - 1 : -1;
+    if (seats && seat >= 0 && seat < seats->header.seatCount && !seatIsFree(*seats, seat)) {
+        releaseSeat(*seats, seat);
+        updateSeatMapFile(*seats);
+    }
+    unlockTable(seatLock);
+    
+    if (!replaced) {
+        cout << "Registration not found" << "\n";
+        return;
+    }
+    cout << "Registration cancelled successfully!" << "\n";
+}
+
+void seatStatus() {
+    int eventID = 0;
+    nextInt(eventID);
+    if (!requestOK()) return;
+    
+    SeatMap* seats = currentSeatMap(eventID);
+    if (!seats) {
+        cout << "No seat map for this event" << "\n";
+        return;
+    }
+    long long largest = 0;
+    for (long long start = nextSetBit(*seats, 0, 0); start >= 0; ) {
+        long long end = nextTakenSeat(*seats, start, seats->header.seatCount);
+        if (end - start > largest) largest = end - start;
+        start = end < seats->header.seatCount ? nextSetBit(*seats, 0, (size_t)end) : -1;
+    }
+    long long next = nextSetBit(*seats, 0, 0);
+    cout << "Event: " << eventID << " Seats: " << seats->header.seatCount << " Free: " << seats->header.freeCount
+         << " Sold: " << seats->header.seatCount - seats->header.freeCount << " Next Seat: ";
+    if (next >= 0) {
+        cout << next + 1;
+    } else {
+        cout << "none";
+    }
+    cout << " Largest Block: " << largest << "\n";
+}
+
+void seatBenchmark() {
+    // Allocation rates on an in-memory map (no files): fill seat by seat, release everything
+    // in random order, then refill in groups
+    int seatCount = 0, groupSize = 0;
+    if (!nextInt(seatCount) || seatCount <= 0 || seatCount > MAX_EVENT_SEATS) seatCount = 100000;
+    if (!nextInt(groupSize) || groupSize <= 0 || groupSize > MAX_GROUP_SIZE) groupSize = 8;
+    
+    SeatMap map;
+    initSeatMap(map, 0, seatCount);
+    auto start = chrono::steady_clock::now();
+    for (long long seat = nextSetBit(map, 0, 0); seat >= 0; seat = nextSetBit(map, 0, 0)) takeSeat(map, seat);
+    double fillMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    
+    vector<int> order(seatCount);
+    for (int i = 0; i < seatCount; i++) order[i] = i;
+    for (int i = seatCount - 1; i > 0; i--) swap(order[i], order[rand() % (i + 1)]);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < seatCount; i++) releaseSeat(map, order[i]);
+    double releaseMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    
+    long long groups = 0;
+    start = chrono::steady_clock::now();
+    for (long long block = findSeatBlock(map, groupSize); block >= 0; block = findSeatBlock(map, groupSize)) {
+        for (int i = 0; i < groupSize; i++) takeSeat(map, block + i);
+        groups++;
+    }
+    double groupMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    
+    cout << fixed << setprecision(3);
+    cout << "Seats: " << seatCount << " Summary Levels: " << map.levels.size() - 1 << "\n";
+    cout << "Single Allocations: " << seatCount << " Time: " << fillMs << " ms"
+         << " Rate: " << (fillMs > 0 ? seatCount / fillMs * 1000.0 : 0.0) << " /s" << "\n";
+    cout << "Releases: " << seatCount << " Time: " << releaseMs << " ms"
+         << " Rate: " << (releaseMs > 0 ? seatCount / releaseMs * 1000.0 : 0.0) << " /s" << "\n";
+    cout << "Group Allocations (" << groupSize << " seats): " << groups << " Time: " << groupMs << " ms"
+         << " Rate: " << (groupMs > 0 ? groups / groupMs * 1000.0 : 0.0) << " /s" << "\n";
+}
+
+// Query engine function definitions
+// Op 28 filters any table by field predicates without a hand-written scan per struct. Each
+// predicate gets a scan kernel specialised for its field type and operator; kernels run over
+// blocks of records, each one narrowing the block's selection of matching rows. Equalities on
+// the shard key (eventID) or a directory-mapped ID read only one shard in sharded mode.
+
+const TableSchema* findSchema(const char* name) {
+    for (int i = 0; i < SCHEMA_COUNT; i++) {
+        if (strcmp(SCHEMAS[i].name, name) == 0) return &SCHEMAS[i];
+    }
+    return NULL;
+}
+
+int findField(const TableSchema& schema, const char* name, size_t len) {
+    // Index of a queryable field, -1 if unknown or hidden
+    for (int i = 0; i < schema.fieldCount; i++) {
+        const FieldDesc& field = schema.fields[i];
+        if (!field.hidden && strlen(field.name) == len && strncmp(field.name, name, len) == 0) return i;
+    }
+    return -1;
+}
+
+template<CompareOp OP, typename V>
+inline bool compareField(V field, V value) {
+    // OP is a template argument, so each kernel compiles down to a single comparison
+    return OP == CMP_EQ ? field == value
+         : OP == CMP_NE ? field != value
+         : OP == CMP_LT ? field < value
+         : OP == CMP_LE ? field <= value
+         : OP == CMP_GT ? field > value
+         : field >= value;
+}
+
+template<CompareOp OP>
+size_t filterInt(const char* data, size_t recordSize, const QueryPredicate& pred, unsigned* rows, size_t count) {
+    size_t offset = pred.field->offset;
+    int value = pred.intValue;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        int field;
+        memcpy(&field, data + rows[i] * recordSize + offset, sizeof(int));
+        if (compareField<OP>(field, value)) rows[kept++] = rows[i];
+    }
+    return kept;
+}
+
+template<CompareOp OP>
+size_t filterFloat(const char* data, size_t recordSize, const QueryPredicate& pred, unsigned* rows, size_t count) {
+    size_t offset = pred.field->offset;
+    float value = pred.floatValue;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        float field;
+        memcpy(&field, data + rows[i] * recordSize + offset, sizeof(float));
+        if (compareField<OP>(field, value)) rows[kept++] = rows[i];
+    }
+    return kept;
+}
+
+template<CompareOp OP>
+size_t filterText(const char* data, size_t recordSize, const QueryPredicate& pred, unsigned* rows, size_t count) {
+    // Text fields are fixed-size char arrays, not always NUL-terminated when full
+    size_t offset = pred.field->offset;
+    size_t size = pred.field->size;
+    const char* value = pred.textValue;
+    size_t valueLen = pred.textLen;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        const char* field = data + rows[i] * recordSize + offset;
+        size_t len = strnlen(field, size);
+        bool match;
+        if (OP == CMP_CONTAINS) {
+            match = false;
+            for (size_t start = 0; !match && start + valueLen <= len; start++) {
+                match = memcmp(field + start, value, valueLen) == 0;
+            }
+        } else {
+            int cmp = memcmp(field, value, len < valueLen ? len : valueLen);
+            if (cmp == 0) cmp = len < valueLen ? -1 : (len > valueLen ? 1 : 0);
+            match = compareField<OP>(cmp, 0);
+        }
+        if (match) rows[kept++] = rows[i];
+    }
+    return kept;
+}
+
+template<CompareOp OP>
+void pickKernel(QueryPredicate& pred) {
+    switch (pred.field->type) {
+        case FIELD_INT: pred.kernel = filterInt<OP>; break;
+        case FIELD_FLOAT: pred.kernel = filterFloat<OP>; break;
+        case FIELD_TEXT: pred.kernel = filterText<OP>; break;
+    }
+}
+
+bool parsePredicate(const TableSchema& schema, const char* line, QueryPredicate& pred) {
+    // "<field> <op> <value>", e.g. "eventID = 500" or "name ~ Ali"; the value is the rest of the line
+    static const char* opNames[] = { "=", "!=", "<", "<=", ">", ">=", "~" };
+    static const CompareOp ops[] = { CMP_EQ, CMP_NE, CMP_LT, CMP_LE, CMP_GT, CMP_GE, CMP_CONTAINS };
+    
+    const char* fieldEnd = strchr(line, ' ');
+    if (!fieldEnd) return false;
+    int fieldIndex = findField(schema, line, fieldEnd - line);
+    if (fieldIndex < 0) return false;
+    pred.field = &schema.fields[fieldIndex];
+    
+    const char* opStart = fieldEnd + 1;
+    const char* opEnd = strchr(opStart, ' ');
+    size_t opLen = opEnd ? (size_t)(opEnd - opStart) : strlen(opStart);
+    const char* value = opEnd ? opEnd + 1 : opStart + opLen;
+    int opIndex = -1;
+    for (int i = 0; i < 7; i++) {
+        if (strlen(opNames[i]) == opLen && strncmp(opNames[i], opStart, opLen) == 0) opIndex = i;
+    }
+    if (opIndex < 0) return false;
+    pred.op = ops[opIndex];
+    
+    char* end;
+    errno = 0;
+    switch (pred.field->type) {
+        case FIELD_INT: {
+            long parsed = strtol(value, &end, 10);
+            if (end == value || *end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX) return false;
+            pred.intValue = (int)parsed;
+            break;
+        }
+        case FIELD_FLOAT:
+            pred.floatValue = strtof(value, &end);
+            if (end == value || *end != '\0' || errno == ERANGE) return false;
+            break;
+        case FIELD_TEXT:
+            pred.textLen = strlen(value);
+            if (pred.textLen >= sizeof(pred.textValue)) return false;
+            memcpy(pred.textValue, value, pred.textLen + 1);
+            break;
+    }
+    
+    switch (pred.op) {
+        case CMP_EQ: pickKernel<CMP_EQ>(pred); break;
+        case CMP_NE: pickKernel<CMP_NE>(pred); break;
+        case CMP_LT: pickKernel<CMP_LT>(pred); break;
+        case CMP_LE: pickKernel<CMP_LE>(pred); break;
+        case CMP_GT: pickKernel<CMP_GT>(pred); break;
+        case CMP_GE: pickKernel<CMP_GE>(pred); break;
+        case CMP_CONTAINS:
+            if (pred.field->type != FIELD_TEXT) return false;  // substring match is text-only
+            pred.kernel = filterText<CMP_CONTAINS>;
+            break;
+    }
+    return true;
+}
+
+int parseProjection(const TableSchema& schema, const char* list, int* columns) {
+    // "name,email" -> field indices; "*" -> every queryable field. Returns -1 on an unknown field.
+    int count = 0;
+    if (strcmp(list, "*") == 0) {
+        for (int i = 0; i < schema.fieldCount; i++) {
+            if (!schema.fields[i].hidden) columns[count++] = i;
+        }
+        return count;
+    }
+    const char* start = list;
+    while (true) {
+        const char* end = strchr(start, ',');
+        size_t len = end ? (size_t)(end - start) : strlen(start);
+        int fieldIndex = findField(schema, start, len);
+        if (fieldIndex < 0 || count == MAX_SCHEMA_FIELDS) return -1;
+        columns[count++] = fieldIndex;
+        if (!end) break;
+        start = end + 1;
+    }
+    return count;
+}
+
+const char* chooseQueryFiles(const TableSchema& schema, const QueryPredicate* preds, int predCount, vector<string>& files) {
+    // Pick the files to scan and name the access path taken
+    if (schema.eventField < 0 || !isShardedMode()) {
+        files.push_back(schema.file);
+        return "full scan";
+    }
+    
+    char path[64];
+    const FieldDesc* eventField = &schema.fields[schema.eventField];
+    const FieldDesc* idField = schema.idField >= 0 ? &schema.fields[schema.idField] : NULL;
+    for (int i = 0; i < predCount; i++) {
+        if (preds[i].field == eventField && preds[i].op == CMP_EQ) {
+            shardFileName(schema.file, preds[i].intValue, path, sizeof(path));
+            files.push_back(path);
+            return "event shard";
+        }
+    }
+    for (int i = 0; i < predCount; i++) {
+        if (preds[i].field == idField && preds[i].op == CMP_EQ) {
+            int eventID;
+            if (findShardedID(schema.file, preds[i].intValue, eventID)) {
+                shardFileName(schema.file, eventID, path, sizeof(path));
+                files.push_back(path);
+            }
+            return "id directory";
+        }
+    }
+    
+    vector<ShardEntry> shards;
+    loadShardManifest(shards);
+    for (size_t i = 0; i < shards.size(); i++) {
+        if (strcmp(shards[i].baseFile, schema.file) != 0) continue;
+        shardFileName(schema.file, shards[i].eventID, path, sizeof(path));
+        files.push_back(path);
+    }
+    return "all shards";
+}
+
+bool filterQueryFiles(const TableSchema& schema, const QueryPredicate* preds, int predCount, vector<string>& files) {
+    // Drop the files whose Bloom filter rules out an equality predicate on a lookup key: ID,
+    // username, or event and customer together for registrations. True if a filter was used.
+    const QueryPredicate* id = NULL;
+    const QueryPredicate* username = NULL;
+    const QueryPredicate* event = NULL;
+    const QueryPredicate* customer = NULL;
+    for (int i = 0; i < predCount; i++) {
+        if (preds[i].op != CMP_EQ) continue;
+        const char* name = preds[i].field->name;
+        if (strcmp(name, "ID") == 0) id = &preds[i];
+        else if (strcmp(name, "username") == 0) username = &preds[i];
+        else if (strcmp(name, "eventID") == 0) event = &preds[i];
+        else if (strcmp(name, "customerID") == 0) customer = &preds[i];
+    }
+    
+    FilterKeyKind kind;
+    const void* key;
+    size_t len;
+    int pair[2];
+    if (id && (schema.filterKeys & (1 << KEY_ID))) {
+        kind = KEY_ID;
+        key = &id->intValue;
+        len = sizeof(int);
+    } else if (username && (schema.filterKeys & (1 << KEY_USERNAME))) {
+        kind = KEY_USERNAME;
+        key = username->textValue;
+        len = username->textLen;
+    } else if (event && customer && (schema.filterKeys & (1 << KEY_REGISTRATION))) {
+        pair[0] = event->intValue;
+        pair[1] = customer->intValue;
+        kind = KEY_REGISTRATION;
+        key = pair;
+        len = sizeof(pair);
+    } else {
+        return false;
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (schema.mayContain(files[i].c_str(), kind, key, len)) files[kept++] = files[i];
+    }
+    files.resize(kept);
+    return true;
+}
+
+void printQueryRow(const TableSchema& schema, const char* record, const int* columns, int columnCount) {
+    for (int c = 0; c < columnCount; c++) {
+        const FieldDesc& field = schema.fields[columns[c]];
+        if (c > 0) cout << " ";
+        cout << field.name << ": ";
+        const char* value = record + field.offset;
+        if (field.type == FIELD_INT) {
+            int number;
+            memcpy(&number, value, sizeof(int));
+            cout << number;
+        } else if (field.type == FIELD_FLOAT) {
+            float number;
+            memcpy(&number, value, sizeof(float));
+            cout << number;
+        } else {
+            cout.write(value, strnlen(value, field.size));
+        }
+    }
+    cout << "\n";
+}
+
+void runQuery() {
+    // Input: table, predicate count, one "<field> <op> <value>" line per predicate (all must match),
+    // projection ("*" or comma-separated fields), row limit (0 for no limit, negative rejected)
+    char tableName[32];
+    int predCount = 0;
+    char lines[MAX_QUERY_PREDICATES][128];
+    char projection[256];
+    int limit = 0;
+    
+    nextText(tableName, sizeof(tableName));
+    nextInt(predCount);
+    if (predCount < 0 || predCount > MAX_QUERY_PREDICATES) {
+        cout << "Too many predicates (max " << MAX_QUERY_PREDICATES << ")" << "\n";
+        return;
+    }
+    for (int i = 0; i < predCount; i++) nextText(lines[i], sizeof(lines[i]));
+    nextText(projection, sizeof(projection));
+    nextInt(limit);
+    if (!requestOK()) return;
+    if (limit < 0) {
+        cout << "Invalid limit: " << limit << "\n";
+        return;
+    }
+    
+    const TableSchema* schema = findSchema(tableName);
+    if (!schema) {
+        cout << "Unknown table: " << tableName << "\n";
+        return;
+    }
+    QueryPredicate preds[MAX_QUERY_PREDICATES];
+    for (int i = 0; i < predCount; i++) {
+        if (!parsePredicate(*schema, lines[i], preds[i])) {
+            cout << "Invalid predicate: " << lines[i] << "\n";
+            return;
+        }
+    }
+    int columns[MAX_SCHEMA_FIELDS];
+    int columnCount = parseProjection(*schema, projection, columns);
+    if (columnCount < 0) {
+        cout << "Invalid projection: " << projection << "\n";
+        return;
+    }
+    
+    vector<string> paths;
+    string access = chooseQueryFiles(*schema, preds, predCount, paths);
+    if (filterQueryFiles(*schema, preds, predCount, paths)) access += " + bloom filter";
+    
+    // Files are read a budget-sized chunk at a time (small shards together in one batch)
+    size_t recordSize = schema->recordSize;
+    size_t scanned = 0, matched = 0;
+    unsigned rows[QUERY_BLOCK_ROWS];
+    bool done = false;
+    scanFiles(paths, recordSize, [&](const char* data, size_t count) {
+        for (size_t start = 0; start < count && !done; start += QUERY_BLOCK_ROWS) {
+            size_t blockRows = count - start < QUERY_BLOCK_ROWS ? count - start : QUERY_BLOCK_ROWS;
+            for (size_t i = 0; i < blockRows; i++) rows[i] = (unsigned)(start + i);
+            size_t selected = blockRows;
+            for (int p = 0; p < predCount && selected > 0; p++) {
+                selected = preds[p].kernel(data, recordSize, preds[p], rows, selected);
+            }
+            scanned += blockRows;
+            for (size_t i = 0; i < selected; i++) {
+                printQueryRow(*schema, data + rows[i] * recordSize, columns, columnCount);
+                if (++matched == (size_t)limit) {
+                    done = true;
+                    break;
+                }
+            }
+        }
+        return !done;
+    });
+    
+    cout << "Rows: " << matched << " Scanned: " << scanned << " Access: " << access << "\n";
+}
+
+// Export function definitions
+// Op 30 writes an event's registrations (joined with customer name and email), staff or
+// vendors as CSV or NDJSON. The data file is read in fixed-size chunks; each chunk is split
+// into one slice per thread, the slices are formatted in parallel into per-thread buffers,
+// and the buffers are written out in order. Memory stays at about one chunk plus its output
+// whatever the size of the event. A file destination is written to a temp file and published
+// with a rename, so nobody sees a half-written export.
+
+void appendExportText(string& out, const char* text, size_t len, ExportFormat format) {
+    if (format == FORMAT_NDJSON) {
+        out += '"';
+        for (size_t i = 0; i < len; i++) {
+            unsigned char c = (unsigned char)text[i];
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += (char)c;
+            } else if (c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += (char)c;
+            }
+        }
+        out += '"';
+        return;
+    }
+    
+    // CSV: quote only values that need it, doubling embedded quotes
+    bool quote = false;
+    for (size_t i = 0; i < len && !quote; i++) {
+        quote = text[i] == ',' || text[i] == '"' || text[i] == '\n' || text[i] == '\r';
+    }
+    if (!quote) {
+        out.append(text, len);
+        return;
+    }
+    out += '"';
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '"') out += '"';
+        out += text[i];
+    }
+    out += '"';
+}
+
+void appendExportValue(string& out, const FieldDesc& field, const char* record, ExportFormat format) {
+    const char* value = record + field.offset;
+    char number[32];
+    if (field.type == FIELD_INT) {
+        // Integers are most of a roster's cells; convert them without snprintf
+        int intValue;
+        memcpy(&intValue, value, sizeof(int));
+        unsigned magnitude = intValue < 0 ? 0u - (unsigned)intValue : (unsigned)intValue;
+        char* end = number + sizeof(number);
+        char* digit = end;
+        do {
+            *--digit = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+        if (intValue < 0) *--digit = '-';
+        out.append(digit, end - digit);
+    } else if (field.type == FIELD_FLOAT) {
+        float floatValue;
+        memcpy(&floatValue, value, sizeof(float));
+        out.append(number, snprintf(number, sizeof(number), "%g", floatValue));
+    } else {
+        appendExportText(out, value, strnlen(value, field.size), format);
+    }
+}
+
+void appendExportRow(string& out, const vector<ExportColumn>& columns, const char* record,
+                     const char* joined, ExportFormat format) {
+    // joined is the customer record for registration columns that come from customers.dat
+    if (format == FORMAT_NDJSON) out += '{';
+    for (size_t c = 0; c < columns.size(); c++) {
+        if (c > 0) out += ',';
+        if (format == FORMAT_NDJSON) {
+            out += '"';
+            out += columns[c].name;
+            out += "\":";
+        }
+        const char* source = columns[c].fromJoin ? joined : record;
+        if (source) {
+            appendExportValue(out, *columns[c].field, source, format);
+        } else {
+            // Registration of a customer that no longer exists, shown as in op 10
+            const char* missing = strcmp(columns[c].name, "email") == 0 ? "unknown@email.com" : "Unknown";
+            appendExportText(out, missing, strlen(missing), format);
+        }
+    }
+    out += format == FORMAT_NDJSON ? "}\n" : "\n";
+}
+
+bool exportColumns(const char* roster, const TableSchema*& schema, vector<ExportColumn>& columns) {
+    // Every visible field of the roster's table; registrations add the customer's name and email
+    schema = findSchema(roster);
+    if (!schema || (schema->file != REG_FILE && schema->file != STAFF_FILE && schema->file != VENDOR_FILE)) return false;
+    for (int i = 0; i < schema->fieldCount; i++) {
+        if (schema->fields[i].hidden) continue;
+        ExportColumn column = { schema->fields[i].name, &schema->fields[i], false };
+        columns.push_back(column);
+    }
+    if (schema->file == REG_FILE) {
+        const TableSchema* customers = findSchema("customers");
+        const char* joinedNames[] = { "name", "email" };
+        for (int i = 0; i < 2; i++) {
+            int field = findField(*customers, joinedNames[i], strlen(joinedNames[i]));
+            ExportColumn column = { joinedNames[i], &customers->fields[field], true };
+            columns.push_back(column);
+        }
+    }
+    return true;
+}
+
+void exportRoster() {
+    // Input: event ID, roster (registrations, staff or vendors), format (csv or ndjson),
+    // destination path ("-" for stdout)
+    int eventID = 0;
+    char roster[32], formatName[16], destination[512];
+    nextInt(eventID);
+    nextText(roster, sizeof(roster));
+    nextText(formatName, sizeof(formatName));
+    nextText(destination, sizeof(destination));
+    if (!requestOK()) return;
+    
+    const TableSchema* schema = NULL;
+    vector<ExportColumn> columns;
+    if (!exportColumns(roster, schema, columns)) {
+        cout << "Unknown roster: " << roster << "\n";
+        return;
+    }
+    ExportFormat format;
+    if (strcmp(formatName, "csv") == 0) {
+        format = FORMAT_CSV;
+    } else if (strcmp(formatName, "ndjson") == 0) {
+        format = FORMAT_NDJSON;
+    } else {
+        cout << "Unknown format: " << formatName << "\n";
+        return;
+    }
+    
+    auto startTime = chrono::steady_clock::now();
+    bool toStdout = strcmp(destination, "-") == 0;
+    char tempName[528];
+    ofstream file;
+    if (!toStdout) {
+        tempFileName(destination, tempName, sizeof(tempName));
+        file.open(tempName, ios::binary | ios::trunc);
+        if (!file) {
+            cout << "Export failed: cannot write " << destination << "\n";
+            return;
+        }
+    }
+    ostream& out = toStdout ? static_cast<ostream&>(cout) : static_cast<ostream&>(file);
+    
+    // Customers are indexed by ID once; registrations of the event then join against it. If
+    // customers.dat is too big for the memory budget, the rows come from the spilling join instead.
+    vector<Customer> customers;
+    RecordIndex custByID;
+    bool join = schema->file == REG_FILE;
+    long long custSize = 0;
+    unsigned long long custIno;
+    bool spill = join && dataIdentity(CUST_FILE, custSize, custIno) && !fitsInMemory(custSize);
+    if (join && !spill) {
+        loadRecords(CUST_FILE, customers);
+        buildRecordIndex(static_cast<const char*>(static_cast<const void*>(customers.data())), sizeof(Customer),
+                         customers.size(), offsetof(Customer, ID), custByID);
+    }
+    
+    long long bytes = 0;
+    if (format == FORMAT_CSV) {
+        string header;
+        for (size_t c = 0; c < columns.size(); c++) {
+            if (c > 0) header += ',';
+            header += columns[c].name;
+        }
+        header += '\n';
+        out.write(header.data(), header.size());
+        bytes += header.size();
+    }
+    
+    // Read the event's records as they were when the export started: appends made meanwhile
+    // land past the size taken here, and the open stream pins the file against a rewrite
+    char path[64];
+    const char* dataFile = eventFile(schema->file, eventID, path, sizeof(path));
+    ifstream data;
+    if (!spill) data.open(dataFile, ios::binary | ios::ate);
+    size_t recordSize = schema->recordSize;
+    long long remaining = data.is_open() && data ? (long long)data.tellg() / (long long)recordSize : 0;
+    if (data.is_open() && data) data.seekg(0);
+    size_t eventOffset = schema->fields[schema->eventField].offset;
+    
+    size_t chunkRecords = min(EXPORT_CHUNK_RECORDS, scanChunkRecords(recordSize));
+    vector<char> chunk(spill ? 0 : chunkRecords * recordSize);
+    size_t maxSlices = poolThreads();
+    vector<string> slices(maxSlices);
+    vector<size_t> sliceRows(maxSlices);
+    long long rows = 0;
+    bool joinFailed = false;
+    if (spill) {
+        // Joined rows arrive one at a time in registration order and are formatted on this thread
+        string& text = slices[0];
+        bool joined = joinRegistrations(dataFile, eventID, [&](const Registration& reg, const Customer* cust) {
+            appendExportRow(text, columns, static_cast<const char*>(static_cast<const void*>(&reg)),
+                            static_cast<const char*>(static_cast<const void*>(cust)), format);
+            rows++;
+            if (text.size() >= IO_CHUNK_SIZE) {
+                out.write(text.data(), text.size());
+                bytes += text.size();
+                text.clear();
+            }
+        });
+        out.write(text.data(), text.size());
+        bytes += text.size();
+        joinFailed = !joined && !isEmptyFile(dataFile);  // not just an event without registrations
+    }
+    while (remaining > 0 && out) {
+        size_t count = remaining < (long long)chunkRecords ? (size_t)remaining : chunkRecords;
+        if (!data.read(chunk.data(), count * recordSize)) break;
+        remaining -= count;
+        
+        size_t sliceCount = (count + EXPORT_SLICE_MIN_RECORDS - 1) / EXPORT_SLICE_MIN_RECORDS;
+        if (sliceCount > maxSlices) sliceCount = maxSlices;
+        size_t perSlice = (count + sliceCount - 1) / sliceCount;
+        runParallel(sliceCount, [&](size_t s) {
+            string& text = slices[s];
+            text.clear();
+            sliceRows[s] = 0;
+            size_t end = min(count, (s + 1) * perSlice);
+            for (size_t i = s * perSlice; i < end; i++) {
+                const char* record = chunk.data() + i * recordSize;
+                int recordEvent;
+                memcpy(&recordEvent, record + eventOffset, sizeof(int));
+                if (recordEvent != eventID) continue;
+                const char* joined = NULL;
+                if (join) {
+                    int custID;
+                    memcpy(&custID, record + offsetof(Registration, customerID), sizeof(int));
+                    long long found = findIndexedRecord(custByID, custID);
+                    if (found >= 0) joined = static_cast<const char*>(static_cast<const void*>(&customers[found]));
+                }
+                appendExportRow(text, columns, record, joined, format);
+                sliceRows[s]++;
+            }
+        });
+        for (size_t s = 0; s < sliceCount; s++) {
+            out.write(slices[s].data(), slices[s].size());
+            bytes += slices[s].size();
+            rows += sliceRows[s];
+        }
+    }
+    
+    out.flush();
+    bool ok = (bool)out && remaining == 0 && !joinFailed;
+    if (toStdout) {
+        if (!ok) cerr << "Export failed" << endl;
+        return;
+    }
+    file.close();
+    if (!ok || !file || !publishFile(tempName, destination)) {
+        remove(tempName);
+        cout << "Export failed: cannot write " << destination << "\n";
+        return;
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+    cout << "Exported: " << rows << " Bytes: " << bytes << " Time: " << ms << " ms"
+         << " Rate: " << (ms > 0 ? bytes / ms / 1000.0 : 0.0) << " MB/s" << "\n";
+}
+
+// Request decoder function definitions
+// Requests are decoded in place from the connection's RequestReader buffer, which is reused for
+// every request: no heap allocation per request, and every field is bounds-checked. A decode
+// error is sticky for the rest of the request (like iostream's failbit) and reported by requestOK().
+
+bool fillRequestBuffer() {
+    // Append whatever stdin has available; false once stdin is closed or the buffer is full
+    RequestReader& in = *input;
+    if (in.closed || in.buffered == REQUEST_BUFFER_SIZE) return false;
+#ifdef _WIN32
+    int n = _read(0, in.buffer + in.buffered, (unsigned)(REQUEST_BUFFER_SIZE - in.buffered));
+#else
+    ssize_t n;
+    do {
+        n = read(0, in.buffer + in.buffered, REQUEST_BUFFER_SIZE - in.buffered);
+    } while (n < 0 && errno == EINTR);
+#endif
+    if (n <= 0) {
+        in.closed = true;
+        return false;
+    }
+    in.buffered += (size_t)n;
+    return true;
+}
+
+bool readWholeRequest() {
+    // One-shot mode: the request is everything on stdin
+    while (fillRequestBuffer()) {}
+    RequestReader& in = *input;
+    in.start = 0;
+    in.end = in.next = in.buffered;
+    if (!in.closed) in.error = "request too large";
+    return true;
+}
+
+bool findFramedRequest() {
+    // Server mode: a request is a line holding its body's length in bytes, then the body (the
+    // usual input lines). The length alone decides where a request ends, so no field value can
+    // end it early or smuggle in another request.
+    RequestReader& in = *input;
+    if (!in.haveLength) {
+        const char* newline = static_cast<const char*>(memchr(in.buffer, '\n', in.buffered));
+        if (!newline && in.buffered < MAX_LENGTH_LINE) return false;
+        // Without a newline in reach, everything buffered is failed as one request
+        size_t lineEnd = newline ? (size_t)(newline - in.buffer) : in.buffered - 1;
+        size_t digits = lineEnd > 0 && in.buffer[lineEnd - 1] == '\r' ? lineEnd - 1 : lineEnd;
+        unsigned long long length = 0;
+        bool valid = newline && digits > 0 && digits < MAX_LENGTH_LINE;
+        for (size_t i = 0; valid && i < digits; i++) {
+            if (!isdigit((unsigned char)in.buffer[i])) valid = false;
+            length = length * 10 + (unsigned)(in.buffer[i] - '0');
+        }
+        in.bodyStart = lineEnd + 1;
+        if (!valid) {
+            in.start = in.end = in.next = in.bodyStart;
+            in.error = "invalid request length";
+            return true;
+        }
+        in.haveLength = true;
+        in.bodySize = (size_t)length;
+        if (length > REQUEST_BUFFER_SIZE - in.bodyStart) {
+            // Too big to hold: drop the body as it arrives, then answer it as one failed request
+            in.discardLeft = (size_t)length;
+            memmove(in.buffer, in.buffer + in.bodyStart, in.buffered - in.bodyStart);
+            in.buffered -= in.bodyStart;
+            in.bodyStart = in.bodySize = 0;
+        }
+    }
+    if (in.discardLeft > 0) {
+        size_t drop = in.discardLeft < in.buffered ? in.discardLeft : in.buffered;
+        memmove(in.buffer, in.buffer + drop, in.buffered - drop);
+        in.buffered -= drop;
+        in.discardLeft -= drop;
+        if (in.discardLeft > 0) return false;
+        in.start = in.end = in.next = 0;
+        in.error = "request too large";
+        return true;
+    }
+    if (in.buffered - in.bodyStart < in.bodySize) return false;
+    in.start = in.bodyStart;
+    in.end = in.next = in.bodyStart + in.bodySize;
+    in.error = NULL;
+    return true;
+}
+
+void finishRequest() {
+    // Shift any following (pipelined) requests to the front of the buffer
+    RequestReader& in = *input;
+    memmove(in.buffer, in.buffer + in.next, in.buffered - in.next);
+    in.buffered -= in.next;
+    in.start = in.end = in.next = in.bodyStart = in.bodySize = 0;
+    in.haveLength = false;
+    in.error = NULL;
+}
+
+bool nextToken(char* token, size_t tokenSize) {
+    // Next whitespace-separated token; a token alone on its line also consumes the line break,
+    // so a following text field starts on the next line (what cin.ignore() used to do)
+    RequestReader& in = *input;
+    if (in.error) return false;
+    while (in.start < in.end && isspace((unsigned char)in.buffer[in.start])) in.start++;
+    size_t len = 0;
+    while (in.start < in.end && !isspace((unsigned char)in.buffer[in.start])) {
+        if (len + 1 >= tokenSize) {
+            in.error = "number too long";
+            return false;
+        }
+        token[len++] = in.buffer[in.start++];
+    }
+    token[len] = '\0';
+    if (len == 0) {
+        in.error = "missing field";
+        return false;
+    }
+    size_t pos = in.start;
+    while (pos < in.end && (in.buffer[pos] == ' ' || in.buffer[pos] == '\t' || in.buffer[pos] == '\r')) pos++;
+    if (pos == in.end || in.buffer[pos] == '\n') in.start = pos < in.end ? pos + 1 : pos;
+    return true;
+}
+
+bool nextLong(long long& value) {
+    char token[24];
+    if (!nextToken(token, sizeof(token))) return false;
+    char* end;
+    errno = 0;
+    long long parsed = strtoll(token, &end, 10);
+    if (*end != '\0' || errno == ERANGE) {
+        input->error = "expected a number";
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool nextInt(int& value) {
+    long long parsed;
+    if (!nextLong(parsed)) return false;
+    if (parsed < INT_MIN || parsed > INT_MAX) {
+        input->error = "number out of range";
+        return false;
+    }
+    value = (int)parsed;
+    return true;
+}
+
+bool nextFloat(float& value) {
+    char token[48];
+    if (!nextToken(token, sizeof(token))) return false;
+    char* end;
+    errno = 0;
+    float parsed = strtof(token, &end);
+    if (*end != '\0' || errno == ERANGE) {
+        input->error = "expected a number";
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool nextText(char* dest, size_t destSize) {
+    // Next whole line into a fixed-size field; too-long values are rejected, never truncated
+    RequestReader& in = *input;
+    if (in.error) return false;
+    if (in.start >= in.end) {
+        in.error = "missing field";
+        return false;
+    }
+    size_t lineEnd = in.start;
+    while (lineEnd < in.end && in.buffer[lineEnd] != '\n') lineEnd++;
+    size_t len = lineEnd - in.start;
+    if (len > 0 && in.buffer[in.start + len - 1] == '\r') len--;
+    if (len >= destSize) {
+        in.error = "field too long";
+        return false;
+    }
+    memcpy(dest, in.buffer + in.start, len);
+    dest[len] = '\0';
+    in.start = lineEnd < in.end ? lineEnd + 1 : lineEnd;
+    return true;
+}
+
+bool requestOK() {
+    // Report a decode error for the current request; ops stop without touching any data
+    if (!input->error) return true;
+    cout << "Invalid input: " << input->error << "\n";
+    return false;
+}
+
+// Output sink for parseBenchmark()
+struct NullBuffer : streambuf {
+    int overflow(int c) { return c; }
+};
+
+void parseBenchmark() {
+    // Time decode + dispatch per op on canned requests against an empty scratch directory, so
+    // the numbers exclude data scanning. The data file names are pointed into it for the run;
+    // the working directory (the resident server's data directory) never changes.
+    int iterations;
+    if (!nextInt(iterations) || iterations <= 0) iterations = 10000;
+    
+#ifdef _WIN32
+    cout << "Parse benchmark is not supported on this platform" << "\n";
+#else
+    static const char* samples[] = {
+        "2\nnobody\nsecret\n",
+        "4\nnobody\nsecret\n",
+        "10\n-1\n",
+        "11\n-1\n-1\nPaid\n",
+        "14\n-1\n",
+        "15\n-1\n",
+        "17\n-1\n",
+        "18\n-1\n",
+        "19\n-1\nSome Name\nsome@mail.com\nTeam\nPosition\n",
+        "20\n-1\nSome Name\nsome@mail.com\nGoods\n12.5\n",
+        "21\n-1\n",
+        "22\n-1\n",
+        "25\n-1\n"
+    };
+    const int sampleCount = sizeof(samples) / sizeof(samples[0]);
+    
+    char scratch[] = "/tmp/ems-parse-XXXXXX";
+    if (!mkdtemp(scratch)) {
+        cout << "Parse benchmark failed: no scratch directory" << "\n";
+        return;
+    }
+    isShardedMode();  // storage mode comes from the real data directory, as for any other op
+    char* names[] = { ORG_FILE, CUST_FILE, REG_FILE, STAFF_FILE, VENDOR_FILE, CHANGE_LOG };
+    const int nameCount = sizeof(names) / sizeof(names[0]);
+    char savedNames[nameCount][FILE_NAME_SIZE];
+    for (int i = 0; i < nameCount; i++) strcpy(savedNames[i], names[i]);
+    for (int i = 0; i < nameCount; i++) {
+        if (snprintf(names[i], FILE_NAME_SIZE, "%s/%s", scratch, savedNames[i]) >= (int)FILE_NAME_SIZE) {
+            for (int j = 0; j <= i; j++) strcpy(names[j], savedNames[j]);
+            rmdir(scratch);
+            cout << "Parse benchmark failed: scratch path too long" << "\n";
+            return;
+        }
     }
     
-    return 0;
+    static RequestReader reader;  // the benchmark's own "connection"
+    RequestReader* connection = input;
+    input = &reader;
+    NullBuffer sink;
+    streambuf* realOut = cout.rdbuf(&sink);
+    streambuf* realErr = cerr.rdbuf(&sink);
+    
+    double nsPerOp[sizeof(samples) / sizeof(samples[0])];
+    for (int s = 0; s < sampleCount; s++) {
+        size_t len = strlen(samples[s]);
+        auto start = chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            memcpy(reader.buffer, samples[s], len);
+            reader.buffered = len;
+            reader.start = 0;
+            reader.end = reader.next = len;
+            reader.error = NULL;
+            int operation;
+            if (nextInt(operation)) dispatchOperation(operation);
+            finishRequest();
+        }
+        nsPerOp[s] = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / iterations;
+    }
+    
+    cout.rdbuf(realOut);
+    cerr.rdbuf(realErr);
+    input = connection;
+    for (int i = 0; i < nameCount; i++) strcpy(names[i], savedNames[i]);
+    
+    // Remove whatever the failing ops created (lock files, shard locks, filters), and their
+    // cached filters
+    size_t scratchLen = strlen(scratch);
+    for (unordered_map<string, BloomFilter>::iterator it = filterCache.begin(); it != filterCache.end(); ) {
+        if (it->first.compare(0, scratchLen, scratch) == 0) {
+            it = filterCache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    DIR* dir = opendir(scratch);
+    if (dir) {
+        char path[128];
+        for (dirent* entry = readdir(dir); entry; entry = readdir(dir)) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+            if (snprintf(path, sizeof(path), "%s/%s", scratch, entry->d_name) < (int)sizeof(path)) remove(path);
+        }
+        closedir(dir);
+    }
+    if (rmdir(scratch) != 0) cout << "Warning: could not remove " << scratch << "\n";
+    
+    cout << "Parse Benchmark: " << iterations << " requests per op" << "\n";
+    for (int s = 0; s < sampleCount; s++) {
+        int operation = atoi(samples[s]);
+        cout << "Op " << operation << ": " << nsPerOp[s] << " ns/request" << "\n";
+    }
+#endif
 }
 
-// Utility function definitions
-bool isEmptyFile(const char* filename) {
-    // Check if file is empty by attempting to read first byte
-    ifstream file(filename, ios::binary);
-    if (!file) return true;  // if the file doesn't exist, return true meaning empty
-    bool isEmpty = file.peek() == EOF;  // Check if immediately end of file is reached
-    file.close();
-    return isEmpty;
+// Change feed function definitions
+// Every insert, update and delete on registrations, staff and vendors is appended to changes.log
+// as one fixed-size ChangeRecord. A change's sequence number is its 1-based position in the log,
+// counting the changes a compaction dropped, so "changes since N" is a single seek. The data
+// files always hold the current state, so a reader whose N predates the log is told to reload.
+
+void logChange(ChangeTable table, ChangeType type, int eventID, int recordID, const void* record, size_t size) {
+    // Must run after the data file write, so a reader never sees a change before its data, and
+    // before that file's lock is released, so changes to one record are logged in write order
+    ChangeRecord change;
+    memset(&change, 0, sizeof(ChangeRecord));
+    change.table = table;
+    change.type = type;
+    change.eventID = eventID;
+    change.recordID = recordID;
+    memcpy(&change.data, record, size < sizeof(change.data) ? size : sizeof(change.data));
+    
+    // Appends share the log's lock with compaction, which replaces the file
+    int lock = lockTable(CHANGE_LOG);
+#ifdef _WIN32
+    ofstream log(CHANGE_LOG, ios::binary | ios::app);
+    log.write(static_cast<char*>(static_cast<void*>(&change)), sizeof(ChangeRecord));
+    log.close();
+#else
+    // O_APPEND makes each whole-record write land at the end of the log
+    int fd = open(CHANGE_LOG, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd >= 0) {
+        ssize_t written = write(fd, &change, sizeof(ChangeRecord));
+        (void)written;
+        close(fd);
+    }
+#endif
+    long long logSize;
+    unsigned long long logIno;
+    if (dataIdentity(CHANGE_LOG, logSize, logIno) && logSize / (long long)sizeof(ChangeRecord) > CHANGE_LOG_MAX_RECORDS) {
+        compactChangeLog();
+    }
+    unlockTable(lock);
 }
 
-bool searchOrganiserID(int targetID) {
-    // Search binary file for organiser with matching ID
-    ifstream file(ORG_FILE, ios::binary);
-    if (!file) return false;
-    Organiser org;
-    while (file.read(static_cast<char*>(static_cast<void*>(&org)), sizeof(Organiser))) {
-        if (org.ID == targetID) {  // Found matching ID
-            file.close();
-            return true;
-        }
+bool openChangeLog(ifstream& log, long long& firstSeq, long long& latestSeq, long long& offset) {
+    // Open the log and find its first change: firstSeq is that change's sequence number, offset
+    // its position in the file, and latestSeq the last change's (firstSeq - 1 if there are none)
+    firstSeq = 1;
+    latestSeq = 0;
+    offset = 0;
+    log.open(CHANGE_LOG, ios::binary | ios::ate);
+    if (!log) return false;
+    long long slots = (long long)log.tellg() / (long long)sizeof(ChangeRecord);
+    log.seekg(0);
+    ChangeRecord header;
+    if (slots > 0 && log.read(static_cast<char*>(static_cast<void*>(&header)), sizeof(ChangeRecord)) && header.table == 0) {
+        long long dropped;
+        memcpy(&dropped, &header.data, sizeof(dropped));
+        firstSeq = dropped + 1;
+        offset = sizeof(ChangeRecord);
+        slots--;
     }
-    file.close();
-    return false;  // ID not found
+    log.clear();
+    latestSeq = firstSeq - 1 + slots;
+    return true;
 }
 
-bool searchCustomerID(int targetID) {
-    ifstream file(CUST_FILE, ios::binary);
-    if (!file) return false;
-    Customer cust;
-    while (file.read(static_cast<char*>(static_cast<void*>(&cust)), sizeof(Customer))) {
-        if (cust.ID == targetID) {
-            file.close();
-            return true;
-        }
+void compactChangeLog() {
+    // Keep the newest CHANGE_LOG_KEEP_RECORDS changes behind a header that counts the rest, so
+    // sequence numbers don't change. Caller holds the log's lock.
+    ifstream log;
+    long long firstSeq, latestSeq, offset;
+    if (!openChangeLog(log, firstSeq, latestSeq, offset)) return;
+    long long keepFrom = max(firstSeq, latestSeq - CHANGE_LOG_KEEP_RECORDS + 1);
+    
+    ChangeRecord header;
+    memset(&header, 0, sizeof(ChangeRecord));
+    long long dropped = keepFrom - 1;
+    memcpy(&header.data, &dropped, sizeof(dropped));
+    char tempName[80];
+    tempFileName(CHANGE_LOG, tempName, sizeof(tempName));
+    ofstream out(tempName, ios::binary | ios::trunc);
+    out.write(static_cast<char*>(static_cast<void*>(&header)), sizeof(ChangeRecord));
+    log.seekg(offset + (keepFrom - firstSeq) * (long long)sizeof(ChangeRecord));
+    vector<char> buffer(IO_CHUNK_SIZE);
+    while (log.read(buffer.data(), buffer.size()) || log.gcount() > 0) {
+        out.write(buffer.data(), log.gcount());
     }
-    file.close();
-    return false;
+    out.close();
+    if (!out) {
+        remove(tempName);
+        return;
+    }
+    publishFile(tempName, CHANGE_LOG);
 }
 
-bool searchEventID(int targetID) {
-    // Events are stored as JSON on frontend, always return false
-    return false;
+long long latestChangeSequence() {
+    ifstream log;
+    long long firstSeq, latestSeq, offset;
+    openChangeLog(log, firstSeq, latestSeq, offset);
+    return latestSeq;
 }
 
-bool searchStaffID(int targetID) {
-    ifstream file(STAFF_FILE, ios::binary);
-    if (!file) return false;
-    Staff staff;
-    while (file.read(static_cast<char*>(static_cast<void*>(&staff)), sizeof(Staff))) {
-        if (staff.ID == targetID) {
-            file.close();
-            return true;
+bool loadChangesSince(long long seq, vector<ChangeRecord>& changes, long long& firstSeq) {
+    // Read every change with sequence > seq that is still in the log; changes[i] has sequence
+    // firstSeq + i. firstSeq > seq + 1 means the ones in between were compacted away.
+    changes.clear();
+    if (seq < 0) seq = 0;
+    ifstream log;
+    long long logFirst, latestSeq, offset;
+    firstSeq = seq + 1;
+    if (!openChangeLog(log, logFirst, latestSeq, offset)) return false;
+    if (seq >= latestSeq) return true;
+    if (firstSeq < logFirst) firstSeq = logFirst;
+    changes.resize((size_t)(latestSeq - firstSeq + 1));
+    log.seekg(offset + (firstSeq - logFirst) * (long long)sizeof(ChangeRecord));
+    log.read(static_cast<char*>(static_cast<void*>(changes.data())), changes.size() * sizeof(ChangeRecord));
+    changes.resize((size_t)log.gcount() / sizeof(ChangeRecord));
+    return true;
+}
+
+void printChange(long long seq, const ChangeRecord& change) {
+    // Header followed by the record in the same format as the matching list op
+    const char* types[] = { "", "insert", "update", "delete" };
+    const char* tables[] = { "", "registrations", "staff", "vendors" };
+    cout << "Change: " << seq << " Table: " << tables[change.table] << " Type: " << types[change.type]
+         << " EventID: " << change.eventID << " ";
+    if (change.table == TABLE_REGISTRATIONS) {
+        const Registration& reg = change.data.reg;
+        cout << "CustID: " << reg.customerID << " Ticket: " << reg.ticketNum << " Status: " << reg.feeStatus << "\n";
+    } else if (change.table == TABLE_STAFF) {
+        const Staff& staff = change.data.staff;
+        cout << "ID: " << staff.ID << " Name: " << staff.name << " Email: " << staff.email 
+             << " Team: " << staff.team << " Position: " << staff.position << "\n";
+    } else {
+        const Vendor& vendor = change.data.vendor;
+        cout << "ID: " << vendor.ID << " Name: " << vendor.name << " Email: " << vendor.email 
+             << " Product/Service: " << vendor.prod_serv << " Charges: " << vendor.chargesDue << "\n";
+    }
+}
+
+void getChangesSince() {
+    // List all changes after the given sequence number (negative: only report the latest)
+    long long seq;
+    nextLong(seq);
+    if (!requestOK()) return;
+    
+    vector<ChangeRecord> changes;
+    long long latest = seq < 0 ? latestChangeSequence() : seq;
+    if (seq >= 0) {
+        long long firstSeq;
+        loadChangesSince(seq, changes, firstSeq);
+        if (firstSeq > seq + 1) cout << "Changes Compacted: " << firstSeq - 1 << "\n";  // caller must reload
+        for (size_t i = 0; i < changes.size(); i++) {
+            printChange(firstSeq + (long long)i, changes[i]);
         }
+        latest = firstSeq - 1 + (long long)changes.size();
     }
-    file.close();
-    return false;
+    
+    cout << "Latest Sequence: " << latest << "\n";
 }
 
-bool searchVendorID(int targetID) {
-    ifstream file(VENDOR_FILE, ios::binary);
-    if (!file) return false;
-    Vendor vendor;
-    while (file.read(static_cast<char*>(static_cast<void*>(&vendor)), sizeof(Vendor))) {
-        if (vendor.ID == targetID) {
-            file.close();
-            return true;
+void subscribeChanges() {
+    // Server mode only: replay changes since seq, then push new ones as they are logged
+    long long seq;
+    nextLong(seq);
+    if (!requestOK()) return;
+    
+    if (!serverMode) {
+        cout << "Subscriptions require server mode" << "\n";
+        return;
+    }
+    
+    subscribedSeq = seq < 0 ? latestChangeSequence() : seq;
+    vector<ChangeRecord> changes;
+    long long firstSeq;
+    loadChangesSince(subscribedSeq, changes, firstSeq);
+    if (firstSeq > subscribedSeq + 1) cout << "Changes Compacted: " << firstSeq - 1 << "\n";
+    for (size_t i = 0; i < changes.size(); i++) {
+        printChange(firstSeq + (long long)i, changes[i]);
+    }
+    subscribedSeq = firstSeq - 1 + (long long)changes.size();
+    
+    cout << "Latest Sequence: " << subscribedSeq << "\n";
+}
+
+void pushChanges() {
+    // Send subscribers every change logged since the last push, as one "END PUSH" block
+    if (subscribedSeq < 0 || latestChangeSequence() <= subscribedSeq) return;
+    
+    vector<ChangeRecord> changes;
+    long long firstSeq;
+    loadChangesSince(subscribedSeq, changes, firstSeq);
+    if (changes.empty()) return;
+    if (firstSeq > subscribedSeq + 1) cout << "Changes Compacted: " << firstSeq - 1 << "\n";  // fell behind a compaction
+    for (size_t i = 0; i < changes.size(); i++) {
+        printChange(firstSeq + (long long)i, changes[i]);
+    }
+    subscribedSeq = firstSeq - 1 + (long long)changes.size();
+    cout << "END PUSH" << "\n";
+    cout.flush();
+}
+
+bool waitForRequest() {
+    // Block until a complete request is buffered, pushing changes made by other processes meanwhile
+    while (!findFramedRequest()) {
+        if (input->closed) return false;
+#ifndef _WIN32
+        pollfd pfd;
+        pfd.fd = 0;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int rc = poll(&pfd, 1, CHANGE_POLL_MS);
+        if (rc == 0) {
+            pushChanges();
+            continue;
         }
+        if (rc < 0 && errno == EINTR) continue;
+#endif
+        fillRequestBuffer();
     }
-    file.close();
-    return false;
+    return true;
 }
 
-bool searchRegistration(int eventID, int custID) {
-    ifstream file(REG_FILE, ios::binary);
-    if (!file) return false;
-    Registration reg;
-    while (file.read(static_cast<char*>(static_cast<void*>(&reg)), sizeof(Registration))) {
-        if (reg.customerID == custID && reg.eventID == eventID) {
-            file.close();
-            return true;
+void serveRequests() {
+    // Resident mode: handle requests until stdin closes. Each request is a line with the byte
+    // length of its usual input lines, then those lines; each response is the op's output
+    // followed by an "END" line.
+    // Pushed change blocks end with "END PUSH" and come before the END of the request that
+    // caused them, or at any point while the server is idle.
+    serverMode = true;
+    
+    while (waitForRequest()) {
+        int operation;
+        if (nextInt(operation)) {
+            dispatchOperation(operation);
+        } else {
+            requestOK();  // say why the request couldn't be decoded
         }
+        
+        // Push this request's own changes (and any others) before completing it
+        pushChanges();
+        cout << "END" << "\n";
+        cout.flush();
+        finishRequest();
     }
-    file.close();
-    return false;
 }
 
 // Organiser function definitions
 void organiserSignup() {
     Organiser org;
     
-    // Generate unique ID (3-digit number: 100-999)
+    nextText(org.name, 50);
+    nextText(org.email, 50);
+    nextText(org.username, 20);
+    nextText(org.password, 20);
+    if (!requestOK()) return;
+    
+    // Generate unique ID (3-digit number: 100-999); the ID lock keeps
+    // concurrent signups from picking the same one before either is written
+    int idLock = lockIDs(ORG_FILE);
     int newID;
     do {
         newID = (rand() % 900) + 100;
     } while (searchOrganiserID(newID));  // Ensure ID is unique
-    
     org.ID = newID;
-    cin.ignore();  // Clear newline from input buffer
-    cin.getline(org.name, 50);
-    cin.getline(org.email, 50);
-    cin.getline(org.username, 20);
-    cin.getline(org.password, 20);
     
     // Append new organiser to binary file
-    ofstream file(ORG_FILE, ios::binary | ios::app);
-    file.write(static_cast<char*>(static_cast<void*>(&org)), sizeof(Organiser));
-    file.close();
+    appendRecord(ORG_FILE, org);
+    unlockTable(idLock);
     
-    cout << "ORGANISER registered successfully!" << endl;
-    cout << "Your ID: " << org.ID << endl;
-    cout.flush();
+    cout << "ORGANISER registered successfully!" << "\n";
+    cout << "Your ID: " << org.ID << "\n";
 }
 
 void organiserLogin() {
     // Authenticate organiser by matching username and password
     char username[20], password[20];
     
-    cin.ignore();
-    cin.getline(username, 20);
-    cin.getline(password, 20);
+    nextText(username, 20);
+    nextText(password, 20);
+    if (!requestOK()) return;
     
-    ifstream file(ORG_FILE, ios::binary);
-    if (!file) {
-        cout << "Invalid credentials" << endl;
-        cout.flush();
+    // Unknown usernames are turned away by the Bloom filter without reading organisers.dat
+    bool userSeen = false, matched = false;
+    Organiser org;
+    if (!filterMayContain<Organiser>(ORG_FILE, KEY_USERNAME, username, strlen(username)) ||
+        !scanRecords<Organiser>(ORG_FILE, [&](const Organiser* orgs, size_t count) {
+            for (size_t i = 0; i < count && !matched; i++) {
+                if (strcmp(orgs[i].username, username) != 0) continue;
+                userSeen = true;
+                // Check if credentials (username and password) match
+                if (strcmp(orgs[i].password, password) == 0) {
+                    org = orgs[i];
+                    matched = true;
+                }
+            }
+            return !matched;
+        })) {
+        cout << "Invalid credentials" << "\n";
         return;
     }
     
-    Organiser org;
-    while (file.read(static_cast<char*>(static_cast<void*>(&org)), sizeof(Organiser))) {
-        // Check if credentials (username and password) match
-        if (strcmp(org.username, username) == 0 && strcmp(org.password, password) == 0) {
-            cout << "ORGANISER LOGIN SUCCESS" << endl;
-            cout << "ID: " << org.ID << " Name: " << org.name << " Email: " << org.email << endl;
-            file.close();
-            cout.flush();
-            return;
-        }
+    if (matched) {
+        cout << "ORGANISER LOGIN SUCCESS" << "\n";
+        cout << "ID: " << org.ID << " Name: " << org.name << " Email: " << org.email << "\n";
+        return;
     }
     
-    file.close();
-    cout << "Invalid credentials" << endl;
-    cout.flush();
+    if (!userSeen) filterScanMissed(ORG_FILE);
+    cout << "Invalid credentials" << "\n";
 }
 
 // Customer function definitions
 void customerSignup() {
     Customer cust;
     
+    nextText(cust.name, 50);
+    nextText(cust.email, 50);
+    nextText(cust.username, 20);
+    nextText(cust.password, 20);
+    if (!requestOK()) return;
+    
+    int idLock = lockIDs(CUST_FILE);
     int newID;
     do {
         newID = (rand() % 900) + 100;
     } while (searchCustomerID(newID));
-    
     cust.ID = newID;
-    cin.ignore();
-    cin.getline(cust.name, 50);
-    cin.getline(cust.email, 50);
-    cin.getline(cust.username, 20);
-    cin.getline(cust.password, 20);
-    
-    ofstream file(CUST_FILE, ios::binary | ios::app);
-    file.write(static_cast<char*>(static_cast<void*>(&cust)), sizeof(Customer));
-    file.close();
     
-    cout << "CUSTOMER registered successfully!" << endl;
-    cout << "Your ID: " << cust.ID << endl;
-    cout.flush();
+    appendRecord(CUST_FILE, cust);
+    unlockTable(idLock);
+    
+    cout << "CUSTOMER registered successfully!" << "\n";
+    cout << "Your ID: " << cust.ID << "\n";
 }
 
 void customerLogin() {
     char username[20], password[20];
     
-    cin.ignore();
-    cin.getline(username, 20);
-    cin.getline(password, 20);
+    nextText(username, 20);
+    nextText(password, 20);
+    if (!requestOK()) return;
     
-    ifstream file(CUST_FILE, ios::binary);
-    if (!file) {
-        cout << "Invalid credentials" << endl;
-        cout.flush();
+    bool userSeen = false, matched = false;
+    Customer cust;
+    if (!filterMayContain<Customer>(CUST_FILE, KEY_USERNAME, username, strlen(username)) ||
+        !scanRecords<Customer>(CUST_FILE, [&](const Customer* custs, size_t count) {
+            for (size_t i = 0; i < count && !matched; i++) {
+                if (strcmp(custs[i].username, username) != 0) continue;
+                userSeen = true;
+                if (strcmp(custs[i].password, password) == 0) {
+                    cust = custs[i];
+                    matched = true;
+                }
+            }
+            return !matched;
+        })) {
+        cout << "Invalid credentials" << "\n";
         return;
     }
     
-    Customer cust;
-    while (file.read(static_cast<char*>(static_cast<void*>(&cust)), sizeof(Customer))) {
-        if (strcmp(cust.username, username) == 0 && strcmp(cust.password, password) == 0) {
-            cout << "CUSTOMER LOGIN SUCCESS" << endl;
-            cout << "ID: " << cust.ID << " Name: " << cust.name << " Email: " << cust.email << endl;
-            file.close();
-            cout.flush();
-            return;
-        }
+    if (matched) {
+        cout << "CUSTOMER LOGIN SUCCESS" << "\n";
+        cout << "ID: " << cust.ID << " Name: " << cust.name << " Email: " << cust.email << "\n";
+        return;
     }
     
-    file.close();
-    cout << "Invalid credentials" << endl;
-    cout.flush();
+    if (!userSeen) filterScanMissed(CUST_FILE);
+    cout << "Invalid credentials" << "\n";
+}
+
+void checkUsername() {
+    // Whether an organiser or customer username is already in use, for the signup forms
+    char table[20], username[20];
+    
+    nextText(table, 20);
+    nextText(username, 20);
+    if (!requestOK()) return;
+    
+    bool taken;
+    if (strcmp(table, "organisers") == 0) {
+        taken = searchUsername<Organiser>(ORG_FILE, username);
+    } else if (strcmp(table, "customers") == 0) {
+        taken = searchUsername<Customer>(CUST_FILE, username);
+    } else {
+        cout << "Unknown table: " << table << "\n";
+        return;
+    }
+    cout << "Username Taken: " << (taken ? "yes" : "no") << "\n";
 }
 
 // Event function definitions
@@ -423,320 +4435,328 @@ void addEvent() {
     event.ID = newID;
     event.soldTickets = 0;
     
-    cin.ignore();
-    cin.getline(event.name, 50);
-    cin.getline(event.startDate, 20);
-    cin.getline(event.endDate, 20);
-    cin.getline(event.venue, 50);
-    cin >> event.totalSeats;
-    int typeVal;
-    cin >> typeVal;
+    nextText(event.name, 50);
+    nextText(event.startDate, 20);
+    nextText(event.endDate, 20);
+    nextText(event.venue, 50);
+    nextInt(event.totalSeats);
+    int typeVal = 0;
+    nextInt(typeVal);
+    if (!requestOK()) return;
     event.type = static_cast<EventType>(typeVal);
     
     // Events are stored as JSON via frontend, not in binary format
-    cout << "Event added successfully!" << endl;
-    cout << "Event ID: " << event.ID << endl;
-    cout.flush();
+    cout << "Event added successfully!" << "\n";
+    cout << "Event ID: " << event.ID << "\n";
 }
 
 void viewEvents() {
     // Events are stored as JSON via frontend, not in binary format
-    cout << "No events found" << endl;
-    cout.flush();
+    cout << "No events found" << "\n";
 }
 
 void modifyEvent() {
-    int eventID;
-    cin >> eventID;
+    int eventID = 0;
+    nextInt(eventID);
+    if (!requestOK()) return;
     
     if (!searchEventID(eventID)) {
-        cout << "Event not found" << endl;
-        cout.flush();
+        cout << "Event not found" << "\n";
         return;
     }
     
     // Events are modified via frontend JSON, not binary format
-    cout << "Event Updated successfully!" << endl;
-    cout.flush();
+    cout << "Event Updated successfully!" << "\n";
 }
 
 void deleteEvent() {
-    int eventID;
-    cin >> eventID;
+    int eventID = 0;
+    nextInt(eventID);
+    if (!requestOK()) return;
     
     if (!searchEventID(eventID)) {
-        cout << "Event not found" << endl;
-        cout.flush();
+        cout << "Event not found" << "\n";
         return;
     }
     
     // Events are deleted via frontend JSON, not binary format
-    cout << "Event Deleted successfully!" << endl;
-    cout.flush();
+    cout << "Event Deleted successfully!" << "\n";
 }
 
 // Registration function definitions
 void addRegistration() {
     Registration reg;
     
-    cin >> reg.customerID;
-    cin >> reg.eventID;
-    cin >> reg.ticketNum;
-    cin.ignore();
-    cin.getline(reg.feeStatus, 10);
+    nextInt(reg.customerID);
+    nextInt(reg.eventID);
+    nextInt(reg.ticketNum);
+    nextText(reg.feeStatus, 10);
+    if (!requestOK()) return;
     
-    ofstream file(REG_FILE, ios::binary | ios::app);
-    file.write(static_cast<char*>(static_cast<void*>(&reg)), sizeof(Registration));
-    file.close();
+    // Duplicate check, seat allocation and append under the event's lock, so a customer can't
+    // be registered twice and a seat can't be sold twice; the file itself is locked only to append
+    int seatLock = lockEventSeats(reg.eventID);
+    int ticketNum;
+    if (searchRegistration(reg.eventID, reg.customerID, ticketNum)) {
+        unlockTable(seatLock);
+        cout << "Already Registered! Your ticket number is " << ticketNum << "\n";
+        return;
+    }
     
-    cout << "Registration added successfully!" << endl;
-    cout.flush();
+    // With a seat map the backend picks the seat and the ticket number is the seat number;
+    // without one the caller's ticket number is kept (events created before seat maps)
+    SeatMap* seats = currentSeatMap(reg.eventID);
+    if (seats) {
+        long long seat = nextSetBit(*seats, 0, 0);
+        if (seat < 0) {
+            unlockTable(seatLock);
+            cout << "Sold Out! No seats left for this event" << "\n";
+            return;
+        }
+        takeSeat(*seats, seat);
+        if (!updateSeatMapFile(*seats)) {
+            returnSeats(*seats, seat, 1);
+            unlockTable(seatLock);
+            cout << "Failed to save seat map" << "\n";
+            return;
+        }
+        reg.ticketNum = (int)(seat + 1);
+    } else if (reg.ticketNum <= 0) {
+        unlockTable(seatLock);
+        cout << "No seat map for this event" << "\n";
+        return;
+    }
+    if (!appendEventRecord(REG_FILE, reg.eventID, -1, reg)) {
+        if (seats) returnSeats(*seats, reg.ticketNum - 1, 1);
+        unlockTable(seatLock);
+        cout << "Failed to save registration" << "\n";
+        return;
+    }
+    unlockTable(seatLock);
+    
+    cout << "Registration added successfully!" << "\n";
+    cout << "Your ticket number is " << reg.ticketNum << "\n";
 }
 
 void getRegistrationsByCustomer() {
-    int custID;
-    cin >> custID;
+    int custID = 0;
+    nextInt(custID);
+    if (!requestOK()) return;
     
-    ifstream file(REG_FILE, ios::binary);
-    if (!file) {
-        cout << "No registrations found" << endl;
-        cout.flush();
-        return;
+    vector<string> paths;
+    if (isShardedMode()) {
+        // A customer's registrations are spread over every event's shard
+        vector<ShardEntry> shards;
+        loadShardManifest(shards);
+        char path[64];
+        for (size_t i = 0; i < shards.size(); i++) {
+            if (strcmp(shards[i].baseFile, REG_FILE) != 0) continue;
+            shardFileName(REG_FILE, shards[i].eventID, path, sizeof(path));
+            paths.push_back(path);
+        }
+    } else {
+        paths.push_back(REG_FILE);
     }
     
-    Registration reg;
     bool found = false;
-    while (file.read(static_cast<char*>(static_cast<void*>(&reg)), sizeof(Registration))) {
-        if (reg.customerID == custID) {
-            cout << "ID: " << reg.customerID << " EventID: " << reg.eventID 
-                 << " Ticket: " << reg.ticketNum << " Status: " << reg.feeStatus << endl;
-            found = true;
+    bool exists = scanFiles(paths, sizeof(Registration), [&](const char* data, size_t count) {
+        const Registration* regs = static_cast<const Registration*>(static_cast<const void*>(data));
+        for (size_t i = 0; i < count; i++) {
+            const Registration& reg = regs[i];
+            if (reg.customerID == custID) {
+                cout << "ID: " << reg.customerID << " EventID: " << reg.eventID 
+                     << " Ticket: " << reg.ticketNum << " Status: " << reg.feeStatus << "\n";
+                found = true;
+            }
         }
+        return true;
+    });
+    if (!exists && !isShardedMode()) {
+        cout << "No registrations found" << "\n";
+        return;
     }
     
-    file.close();
-    if (!found) cout << "No registrations found for this customer" << endl;
-    cout.flush();
+    if (!found) cout << "No registrations found for this customer" << "\n";
 }
 
 void getRegistrationsByEvent() {
     // Retrieve all registrations for event and registered customer details
-    int eventID;
-    cin >> eventID;
-    
-    ifstream file(REG_FILE, ios::binary);
-    if (!file) {
-        cout << "No registrations found" << endl;
-        cout.flush();
-        return;
-    }
+    int eventID = 0;
+    nextInt(eventID);
+    if (!requestOK()) return;
     
-    Registration reg;
+    // Registrations of the event joined with their customers, within the memory budget
+    char path[64];
     bool found = false;
-    while (file.read(static_cast<char*>(static_cast<void*>(&reg)), sizeof(Registration))) {
-        if (reg.eventID == eventID) {
-            // Look up customer details from customers.dat to display name and email
-            ifstream custFile(CUST_FILE, ios::binary);
-            Customer cust;
-            char custName[50] = "Unknown";
-            char custEmail[50] = "unknown@email.com";
-            bool customerFound = false;
-            
-            while (custFile.read(static_cast<char*>(static_cast<void*>(&cust)), sizeof(Customer))) {
-                if (cust.ID == reg.customerID) {  // Match customer by ID
-                    strcpy(custName, cust.name);
-                    strcpy(custEmail, cust.email);
-                    customerFound = true;
-                    break;
-                }
-            }
-            custFile.close();
-            
-            // Debug output
-            cerr << "DEBUG: Lookup for custID " << reg.customerID << ", found: " << (customerFound ? "YES" : "NO") << ", name: " << custName << ", email: " << custEmail << endl;
-            
-            cout << "CustID: " << reg.customerID << " Name: " << custName << " Email: " << custEmail 
-                 << " Ticket: " << reg.ticketNum << " Status: " << reg.feeStatus << endl;
-            found = true;
+    bool exists = joinRegistrations(eventFile(REG_FILE, eventID, path, sizeof(path)), eventID,
+                                    [&](const Registration& reg, const Customer* cust) {
+        // Look up customer details to display name and email
+        const char* custName = "Unknown";
+        const char* custEmail = "unknown@email.com";
+        bool customerFound = cust != NULL;
+        if (customerFound) {  // Match customer by ID
+            custName = cust->name;
+            custEmail = cust->email;
         }
+        
+        cout << "CustID: " << reg.customerID << " Name: " << custName << " Email: " << custEmail 
+             << " Ticket: " << reg.ticketNum << " Status: " << reg.feeStatus << "\n";
+        found = true;
+    });
+    if (!exists) {
+        cout << "No registrations found" << "\n";
+        return;
     }
     
-    file.close();
-    if (!found) cout << "No registrations found for this event" << endl;
-    cout.flush();
+    if (!found) cout << "No registrations found for this event" << "\n";
 }
 
 void updateRegistrationFeeStatus() {
     // Update payment status for a specific registration
-    int custID, eventID;
+    int custID = 0, eventID = 0;
     char feeStatus[10];
     
-    cin >> custID >> eventID;
-    cin.ignore();
-    cin.getline(feeStatus, 10);
-    
-    cerr << "DEBUG updateRegistrationFeeStatus: custID=" << custID << ", eventID=" << eventID << ", feeStatus=" << feeStatus << endl;
+    nextInt(custID);
+    nextInt(eventID);
+    nextText(feeStatus, 10);
+    if (!requestOK()) return;
     
-    // Copy all records and update only the matching one
-    ifstream fileRead(REG_FILE, ios::binary);
-    ofstream fileWrite("temp.dat", ios::binary);
-    
-    Registration reg;
-    bool found = false;
-    int totalRegs = 0;
-    while (fileRead.read(static_cast<char*>(static_cast<void*>(&reg)), sizeof(Registration))) {
-        totalRegs++;
-        cerr << "DEBUG: Checking reg - custID=" << reg.customerID << ", eventID=" << reg.eventID << endl;
+    // Stream the records through and update only the matching one
+    char path[64];
+    const char* filename = eventFile(REG_FILE, eventID, path, sizeof(path));
+    int lock = lockTable(filename);
+    size_t edits = 0;
+    Registration updated;
+    bool replaced = rewriteRecords<Registration>(filename, [&](Registration& reg) {
         // Find matching registration and update fee status
-        if (reg.customerID == custID && reg.eventID == eventID) {
-            strcpy(reg.feeStatus, feeStatus);
-            found = true;
-            cerr << "DEBUG: Found matching registration, updating feeStatus to " << feeStatus << endl;
-        }
-        fileWrite.write(static_cast<char*>(static_cast<void*>(&reg)), sizeof(Registration));
-    }
-    
-    fileRead.close();
-    fileWrite.close();
+        if (reg.customerID != custID || reg.eventID != eventID) return KEEP_RECORD;
+        strcpy(reg.feeStatus, feeStatus);
+        updated = reg;
+        return CHANGE_RECORD;
+    }, edits) && edits > 0;
+    if (replaced) logChange(TABLE_REGISTRATIONS, CHANGE_UPDATE, eventID, custID, &updated, sizeof(Registration));
+    unlockTable(lock);
     
-    cerr << "DEBUG: Total regs checked: " << totalRegs << ", found: " << (found ? "YES" : "NO") << endl;
-    
-    if (found) {
-        remove(REG_FILE);
-        rename("temp.dat", REG_FILE);
-        cout << "Fee Status Updated successfully!" << endl;
+    if (replaced) {
+        cout << "Fee Status Updated successfully!" << "\n";
     } else {
-        remove("temp.dat");
-        cout << "Registration not found" << endl;
+        cout << "Registration not found" << "\n";
     }
-    cout.flush();
 }
 
 // Staff function definitions
 void addStaffToFile() {
     Staff staff;
     
+    nextInt(staff.eventID);
+    nextText(staff.name, 50);
+    nextText(staff.email, 50);
+    nextText(staff.team, 20);
+    nextText(staff.position, 20);
+    if (!requestOK()) return;
+    
+    int idLock = lockIDs(STAFF_FILE);
     int newID;
     do {
         newID = (rand() % 900) + 100;
     } while (searchStaffID(newID));
-    
     staff.ID = newID;
-    cin >> staff.eventID;
-    cin.ignore();
-    cin.getline(staff.name, 50);
-    cin.getline(staff.email, 50);
-    cin.getline(staff.team, 20);
-    cin.getline(staff.position, 20);
-    
-    ofstream file(STAFF_FILE, ios::binary | ios::app);
-    file.write(static_cast<char*>(static_cast<void*>(&staff)), sizeof(Staff));
-    file.close();
     
-    cout << "Staff member added successfully!" << endl;
-    cout << "Staff ID: " << staff.ID << endl;
-    cout.flush();
+    appendEventRecord(STAFF_FILE, staff.eventID, staff.ID, staff);
+    unlockTable(idLock);
+    
+    cout << "Staff member added successfully!" << "\n";
+    cout << "Staff ID: " << staff.ID << "\n";
 }
 
 void getStaffByEventFile() {
-    int eventID;
-    cin >> eventID;
-    
-    ifstream file(STAFF_FILE, ios::binary);
-    if (!file) {
-        cout << "No staff found" << endl;
-        cout.flush();
-        return;
-    }
+    int eventID = 0;
+    nextInt(eventID);
+    if (!requestOK()) return;
     
-    Staff staff;
+    char path[64];
     bool found = false;
-    while (file.read(static_cast<char*>(static_cast<void*>(&staff)), sizeof(Staff))) {
-        if (staff.eventID == eventID) {
-            cout << "ID: " << staff.ID << " Name: " << staff.name << " Email: " << staff.email 
-                 << " Team: " << staff.team << " Position: " << staff.position << endl;
-            found = true;
+    if (!scanRecords<Staff>(eventFile(STAFF_FILE, eventID, path, sizeof(path)), [&](const Staff* staffList, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            const Staff& staff = staffList[i];
+            if (staff.eventID == eventID) {
+                cout << "ID: " << staff.ID << " Name: " << staff.name << " Email: " << staff.email 
+                     << " Team: " << staff.team << " Position: " << staff.position << "\n";
+                found = true;
+            }
         }
+        return true;
+    })) {
+        cout << "No staff found" << "\n";
+        return;
     }
     
-    file.close();
-    if (!found) cout << "No staff found for this event" << endl;
-    cout.flush();
+    if (!found) cout << "No staff found for this event" << "\n";
 }
 
 void deleteStaffFromFile() {
-    // Delete staff member by copying all records except the record to be deleted to new file
-    int staffID;
-    cin >> staffID;
-    
-    if (!searchStaffID(staffID)) {
-        cout << "Staff not found" << endl;
-        cout.flush();
-        return;
-    }
-    
+    // Delete staff member by rewriting the file without the record to be deleted
+    int staffID = 0;
+    nextInt(staffID);
+    if (!requestOK()) return;
     
-    ifstream fileRead(STAFF_FILE, ios::binary);
-    ofstream fileWrite("temp.dat", ios::binary);
+    char path[64];
+    const char* filename = recordFile(STAFF_FILE, staffID, path, sizeof(path));
+    int lock = filename ? lockTable(filename) : -1;
+    size_t edits = 0;
+    Staff removed;
+    if (filename) rewriteRecords<Staff>(filename, [&](Staff& staff) {
+        if (staff.ID != staffID) return KEEP_RECORD;
+        removed = staff;  // skip the record to delete
+        return DROP_RECORD;
+    }, edits);
+    if (edits > 0) logChange(TABLE_STAFF, CHANGE_DELETE, removed.eventID, staffID, &removed, sizeof(Staff));
+    unlockTable(lock);
     
-    Staff staff;
-    while (fileRead.read(static_cast<char*>(static_cast<void*>(&staff)), sizeof(Staff))) {
-        if (staff.ID != staffID) {  // skip the record to delete
-            fileWrite.write(static_cast<char*>(static_cast<void*>(&staff)), sizeof(Staff));
-        }
+    if (edits == 0) {
+        cout << "Staff not found" << "\n";
+        return;
     }
     
-    fileRead.close();
-    fileWrite.close();
-    
-    remove(STAFF_FILE);
-    rename("temp.dat", STAFF_FILE);
-    
-    cout << "Staff Deleted successfully!" << endl;
-    cout.flush();
+    cout << "Staff Deleted successfully!" << "\n";
 }
 
 void updateStaffInFile() {
     // Update staff member details (read-modify-write pattern)
-    int staffID;
-    cin >> staffID;
-    
-    if (!searchStaffID(staffID)) {
-        cout << "Staff not found" << endl;
-        cout.flush();
-        return;
-    }
-    
+    int staffID = 0;
     char name[50], email[50], team[20], position[20];
-    cin.ignore();
-    cin.getline(name, 50);
-    cin.getline(email, 50);
-    cin.getline(team, 20);
-    cin.getline(position, 20);
+    nextInt(staffID);
+    nextText(name, 50);
+    nextText(email, 50);
+    nextText(team, 20);
+    nextText(position, 20);
+    if (!requestOK()) return;
     
-    // Copy all records, updating matching one
-    ifstream fileRead(STAFF_FILE, ios::binary);
-    ofstream fileWrite("temp.dat", ios::binary);
+    // Hold the writer lock from load to replace so concurrent updates can't overwrite each other
+    char path[64];
+    const char* filename = recordFile(STAFF_FILE, staffID, path, sizeof(path));
+    int lock = filename ? lockTable(filename) : -1;
     
-    Staff staff;
-    while (fileRead.read(static_cast<char*>(static_cast<void*>(&staff)), sizeof(Staff))) {
-        if (staff.ID == staffID) {  // Update target record
-            strcpy(staff.name, name);
-            strcpy(staff.email, email);
-            strcpy(staff.team, team);
-            strcpy(staff.position, position);
-        }
-        fileWrite.write(static_cast<char*>(static_cast<void*>(&staff)), sizeof(Staff));
+    // Update matching records as the file streams through into its new generation
+    size_t edits = 0;
+    Staff updated;
+    if (filename) rewriteRecords<Staff>(filename, [&](Staff& staff) {
+        if (staff.ID != staffID) return KEEP_RECORD;
+        strcpy(staff.name, name);  // Update target record
+        strcpy(staff.email, email);
+        strcpy(staff.team, team);
+        strcpy(staff.position, position);
+        updated = staff;
+        return CHANGE_RECORD;
+    }, edits);
+    if (edits > 0) logChange(TABLE_STAFF, CHANGE_UPDATE, updated.eventID, staffID, &updated, sizeof(Staff));
+    unlockTable(lock);
+    if (edits == 0) {
+        cout << "Staff not found" << "\n";
+        return;
     }
     
-    fileRead.close();
-    fileWrite.close();
-    
-    remove(STAFF_FILE);
-    rename("temp.dat", STAFF_FILE);
-    
-    cout << "Staff Updated successfully!" << endl;
-    cout.flush();
+    cout << "Staff Updated successfully!" << "\n";
 }
 
 // Vendor function definitions
@@ -744,198 +4764,183 @@ void addVendorToFile() {
     // Add new vendor with unique ID and append to binary file
     Vendor vendor;
     
+    nextInt(vendor.eventID);
+    nextText(vendor.name, 50);
+    nextText(vendor.email, 50);
+    nextText(vendor.prod_serv, 50);
+    nextFloat(vendor.chargesDue);
+    if (!requestOK()) return;
+    
     // Generate unique ID (3-digit number: 100-999)
+    int idLock = lockIDs(VENDOR_FILE);
     int newID;
     do {
         newID = (rand() % 900) + 100;
     } while (searchVendorID(newID));  // Ensure ID is unique
-    
     vendor.ID = newID;
-    cin >> vendor.eventID;
-    cin.ignore();  // Clear newline from input buffer
-    cin.getline(vendor.name, 50);
-    cin.getline(vendor.email, 50);
-    cin.getline(vendor.prod_serv, 50);
-    cin >> vendor.chargesDue;
     
     // Append new vendor to binary file
-    ofstream file(VENDOR_FILE, ios::binary | ios::app);
-    file.write(static_cast<char*>(static_cast<void*>(&vendor)), sizeof(Vendor));
-    file.close();
+    appendEventRecord(VENDOR_FILE, vendor.eventID, vendor.ID, vendor);
+    unlockTable(idLock);
     
-    cout << "Vendor added successfully!" << endl;
-    cout << "Vendor ID: " << vendor.ID << endl;
-    cout.flush();
+    cout << "Vendor added successfully!" << "\n";
+    cout << "Vendor ID: " << vendor.ID << "\n";
 }
 
 void getVendorsByEventFile() {
     // Retrieve all vendors for a specific event
-    int eventID;
-    cin >> eventID;
-    
-    ifstream file(VENDOR_FILE, ios::binary);
-    if (!file) {
-        cout << "No vendors found" << endl;
-        cout.flush();
-        return;
-    }
+    int eventID = 0;
+    nextInt(eventID);
+    if (!requestOK()) return;
     
-    Vendor vendor;
+    char path[64];
     bool found = false;
-    while (file.read(static_cast<char*>(static_cast<void*>(&vendor)), sizeof(Vendor))) {
-        if (vendor.eventID == eventID) {  // Match by event ID
-            cout << "ID: " << vendor.ID << " Name: " << vendor.name << " Email: " << vendor.email 
-                 << " Product/Service: " << vendor.prod_serv << " Charges: " << vendor.chargesDue << endl;
-            found = true;
+    if (!scanRecords<Vendor>(eventFile(VENDOR_FILE, eventID, path, sizeof(path)), [&](const Vendor* vendors, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            const Vendor& vendor = vendors[i];
+            if (vendor.eventID == eventID) {  // Match by event ID
+                cout << "ID: " << vendor.ID << " Name: " << vendor.name << " Email: " << vendor.email 
+                     << " Product/Service: " << vendor.prod_serv << " Charges: " << vendor.chargesDue << "\n";
+                found = true;
+            }
         }
+        return true;
+    })) {
+        cout << "No vendors found" << "\n";
+        return;
     }
     
-    file.close();
-    if (!found) cout << "No vendors found for this event" << endl;
-    cout.flush();
+    if (!found) cout << "No vendors found for this event" << "\n";
 }
 
 void deleteVendorFromFile() {
-    // Delete vendor by copying all records except the vendor to be deleted to new file
-    int vendorID;
-    cin >> vendorID;
-    
-    if (!searchVendorID(vendorID)) {
-        cout << "Vendor not found" << endl;
-        cout.flush();
-        return;
-    }
+    // Delete vendor by rewriting the file without the vendor to be deleted
+    int vendorID = 0;
+    nextInt(vendorID);
+    if (!requestOK()) return;
     
-    // Read-modify-write: skip the record to delete
-    ifstream fileRead(VENDOR_FILE, ios::binary);
-    ofstream fileWrite("temp.dat", ios::binary);
+    char path[64];
+    const char* filename = recordFile(VENDOR_FILE, vendorID, path, sizeof(path));
+    int lock = filename ? lockTable(filename) : -1;
+    size_t edits = 0;
+    Vendor removed;
+    if (filename) rewriteRecords<Vendor>(filename, [&](Vendor& vendor) {
+        if (vendor.ID != vendorID) return KEEP_RECORD;  // Copy all except target
+        removed = vendor;
+        return DROP_RECORD;
+    }, edits);
+    if (edits > 0) logChange(TABLE_VENDORS, CHANGE_DELETE, removed.eventID, vendorID, &removed, sizeof(Vendor));
+    unlockTable(lock);
     
-    Vendor vendor;
-    while (fileRead.read(static_cast<char*>(static_cast<void*>(&vendor)), sizeof(Vendor))) {
-        if (vendor.ID != vendorID) {  // Copy all except target
-            fileWrite.write(static_cast<char*>(static_cast<void*>(&vendor)), sizeof(Vendor));
-        }
+    if (edits == 0) {
+        cout << "Vendor not found" << "\n";
+        return;
     }
     
-    fileRead.close();
-    fileWrite.close();
-    
-    remove(VENDOR_FILE);
-    rename("temp.dat", VENDOR_FILE);
-    
-    cout << "Vendor Deleted successfully!" << endl;
-    cout.flush();
+    cout << "Vendor Deleted successfully!" << "\n";
 }
 
 void updateVendorInFile() {
     // Update vendor details (read-modify-write pattern)
-    int vendorID;
-    cin >> vendorID;
-    
-    if (!searchVendorID(vendorID)) {
-        cout << "Vendor not found" << endl;
-        cout.flush();
-        return;
-    }
-    
+    int vendorID = 0;
     char name[50], email[50], prod_serv[50];
     float chargesDue;
-    cin.ignore();
-    cin.getline(name, 50);
-    cin.getline(email, 50);
-    cin.getline(prod_serv, 50);
-    cin >> chargesDue;
+    nextInt(vendorID);
+    nextText(name, 50);
+    nextText(email, 50);
+    nextText(prod_serv, 50);
+    nextFloat(chargesDue);
+    if (!requestOK()) return;
     
-    // Copy all records, updating matching one
-    ifstream fileRead(VENDOR_FILE, ios::binary);
-    ofstream fileWrite("temp.dat", ios::binary);
+    // Hold the writer lock from load to replace so concurrent updates can't overwrite each other
+    char path[64];
+    const char* filename = recordFile(VENDOR_FILE, vendorID, path, sizeof(path));
+    int lock = filename ? lockTable(filename) : -1;
     
-    Vendor vendor;
-    while (fileRead.read(static_cast<char*>(static_cast<void*>(&vendor)), sizeof(Vendor))) {
-        if (vendor.ID == vendorID) {  // Update target record
-            strcpy(vendor.name, name);
-            strcpy(vendor.email, email);
-            strcpy(vendor.prod_serv, prod_serv);
-            vendor.chargesDue = chargesDue;
-        }
-        fileWrite.write(static_cast<char*>(static_cast<void*>(&vendor)), sizeof(Vendor));
+    // Update matching records as the file streams through into its new generation
+    size_t edits = 0;
+    Vendor updated;
+    if (filename) rewriteRecords<Vendor>(filename, [&](Vendor& vendor) {
+        if (vendor.ID != vendorID) return KEEP_RECORD;
+        strcpy(vendor.name, name);  // Update target record
+        strcpy(vendor.email, email);
+        strcpy(vendor.prod_serv, prod_serv);
+        vendor.chargesDue = chargesDue;
+        updated = vendor;
+        return CHANGE_RECORD;
+    }, edits);
+    if (edits > 0) logChange(TABLE_VENDORS, CHANGE_UPDATE, updated.eventID, vendorID, &updated, sizeof(Vendor));
+    unlockTable(lock);
+    if (edits == 0) {
+        cout << "Vendor not found" << "\n";
+        return;
     }
     
-    fileRead.close();
-    fileWrite.close();
-    
-    remove(VENDOR_FILE);
-    rename("temp.dat", VENDOR_FILE);
-    
-    cout << "Vendor Updated successfully!" << endl;
-    cout.flush();
+    cout << "Vendor Updated successfully!" << "\n";
 }
 
 // Recursive function to count staff members by event
-int countStaffByEventRecursive(vector<Staff>& staff, int index, int eventID) {
+int countStaffByEventRecursive(const Staff* staff, size_t count, size_t index, int eventID) {
     // Base case: all staff members have been processed
-    if (index >= staff.size()) {
+    if (index >= count) {
         return 0;
     }
     // Recursive case: add 1 if current staff belongs to event and then recurse on the rest
-    int count = (staff[index].eventID == eventID) ? 1 : 0;
-    return count + countStaffByEventRecursive(staff, index + 1, eventID);
+    int matched = (staff[index].eventID == eventID) ? 1 : 0;
+    return matched + countStaffByEventRecursive(staff, count, index + 1, eventID);
 }
 
 // Recursive function to count vendors by event
-int countVendorsByEventRecursive(vector<Vendor>& vendors, int index, int eventID) {
-    if (index >= vendors.size()) {
-        return 0;  // Base case: reached end of vector
+int countVendorsByEventRecursive(const Vendor* vendors, size_t count, size_t index, int eventID) {
+    if (index >= count) {
+        return 0;  // Base case: reached end of block
     }
     // Recursive case: count current + recurse for remaining
-    int count = (vendors[index].eventID == eventID) ? 1 : 0;
-    return count + countVendorsByEventRecursive(vendors, index + 1, eventID);
+    int matched = (vendors[index].eventID == eventID) ? 1 : 0;
+    return matched + countVendorsByEventRecursive(vendors, count, index + 1, eventID);
 }
 
 void getStaffCountByEvent() {
     // Count staff members for event using recursion
-    int eventID;
-    cin >> eventID;
+    int eventID = 0;
+    nextInt(eventID);
+    if (!requestOK()) return;
 
-    ifstream inFile(STAFF_FILE, ios::binary);
-    if (!inFile) {
-        cout << "Staff Count: 0" << endl;
+    // Read staff records a chunk at a time; the recursion runs over fixed-size blocks of each
+    // chunk, so neither memory nor stack depth grows with the file
+    char path[64];
+    int count = 0;
+    if (!scanRecords<Staff>(eventFile(STAFF_FILE, eventID, path, sizeof(path)), [&](const Staff* staff, size_t records) {
+        for (size_t start = 0; start < records; start += RECURSION_BLOCK_RECORDS) {
+            count += countStaffByEventRecursive(staff + start, min(records - start, RECURSION_BLOCK_RECORDS), 0, eventID);
+        }
+        return true;
+    })) {
+        cout << "Staff Count: 0" << "\n";
         return;
     }
 
-    // Load all staff records into vector
-    vector<Staff> staff;
-    Staff s;
-    while (inFile.read(static_cast<char*>(static_cast<void*>(&s)), sizeof(Staff))) {
-        staff.push_back(s);
-    }
-    inFile.close();
-
-    // Use recursive function to count matching staff
-    int count = countStaffByEventRecursive(staff, 0, eventID);
-    cout << "Staff Count: " << count << endl;
+    cout << "Staff Count: " << count << "\n";
 }
 
 void getVendorCountByEvent() {
     // Count vendors for event using recursion
-    int eventID;
-    cin >> eventID;
+    int eventID = 0;
+    nextInt(eventID);
+    if (!requestOK()) return;
 
-    ifstream inFile(VENDOR_FILE, ios::binary);
-    if (!inFile) {
-        cout << "Vendor Count: 0" << endl;
+    // Read vendor records a chunk at a time and count each block recursively
+    char path[64];
+    int count = 0;
+    if (!scanRecords<Vendor>(eventFile(VENDOR_FILE, eventID, path, sizeof(path)), [&](const Vendor* vendors, size_t records) {
+        for (size_t start = 0; start < records; start += RECURSION_BLOCK_RECORDS) {
+            count += countVendorsByEventRecursive(vendors + start, min(records - start, RECURSION_BLOCK_RECORDS), 0, eventID);
+        }
+        return true;
+    })) {
+        cout << "Vendor Count: 0" << "\n";
         return;
     }
 
-    // load all vendor records into vector
-    vector<Vendor> vendors;
-    Vendor v;
-    while (inFile.read(static_cast<char*>(static_cast<void*>(&v)), sizeof(Vendor))) {
-        vendors.push_back(v);
-    }
-    inFile.close();
-
-    // Use recursive function to count matching vendors
-    int count = countVendorsByEventRecursive(vendors, 0, eventID);
-    cout << "Vendor Count: " << count << endl;
+    cout << "Vendor Count: " << count << "\n";
 }
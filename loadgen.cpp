@@ -0,0 +1,839 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+using namespace std;
+
+// Ticket-rush load generator and trace replayer for the EMS backend (Linux/macOS only).
+// Build: g++ -std=c++11 -O2 -pthread -o loadgen loadgen.cpp
+// Runs against a scratch data directory unless --data is given; see usage() for options.
+
+// DEFAULT SETTINGS
+const int DEFAULT_CLIENTS = 32;
+const int DEFAULT_REQUESTS = 4000;
+const int DEFAULT_EVENT_ID = 900;
+const int DEFAULT_SEATS = 100;
+const int MAX_CUSTOMERS = 800;          // customer IDs are 3 digits (100-999): stay clear of running out
+const int REQUEST_TIMEOUT_MS = 10000;   // slower requests are killed and counted as timeouts
+const int SEED_STAFF = 3;               // staff/vendors added before the run; the count ops must report these
+const int SEED_VENDORS = 2;
+
+// ENUM DEFINITIONS
+
+// Kinds of request in the mix
+enum LoadOp { LOAD_SIGNUP = 0, LOAD_LOGIN, LOAD_REGISTER, LOAD_POLL, LOAD_COUNT, LOAD_OP_COUNT };
+const char* LOAD_OP_NAMES[LOAD_OP_COUNT] = { "signup", "login", "register", "poll", "count" };
+
+// STRUCT DEFINITIONS
+
+struct LoadOptions {
+    string backend;         // backend executable
+    string dataDir;         // data directory (empty: a scratch directory)
+    string recordFile;      // write the requests issued to this trace file
+    string replayFile;      // replay this trace instead of generating requests
+    bool resident;          // one "backend --serve" per client instead of a process per request
+    bool keepData;
+    bool paced;             // replay at the recorded times instead of as fast as possible
+    int clients, requests, eventID, seats;
+    double durationSec;     // run for this long instead of a request count (0: use requests)
+    int mix[LOAD_OP_COUNT]; // relative weights of each kind of request
+};
+
+// One backend request: op code and input lines. A customer ID written as "@username" is
+// resolved to that customer's ID when the request is sent, so traces replay after new signups.
+struct LoadRequest {
+    long long atUs;  // send time since the start of the run
+    int client;
+    int opCode;
+    vector<string> fields;
+};
+
+// A backend child process with pipes to its stdin and stdout
+struct BackendProcess {
+    pid_t pid;
+    int toChild, fromChild;
+    string pending;  // output read but not yet consumed
+};
+
+// What one client saw; merged after the run
+struct ClientResult {
+    vector<double> latencyUs[LOAD_OP_COUNT];
+    long long ok[LOAD_OP_COUNT], rejected[LOAD_OP_COUNT], failed[LOAD_OP_COUNT], timeouts[LOAD_OP_COUNT];
+    long long failedLogins;     // known customers refused at login
+    long long pollRegressions;  // an event's registration list shrank between polls
+    long long countMismatches;  // count ops disagreeing with the seeded staff/vendors
+    vector<LoadRequest> trace;
+    ClientResult() : failedLogins(0), pollRegressions(0), countMismatches(0) {
+        for (int i = 0; i < LOAD_OP_COUNT; i++) ok[i] = rejected[i] = failed[i] = timeouts[i] = 0;
+    }
+};
+
+// FUNCTION PROTOTYPES
+
+// Setup functions
+void usage();
+bool parseOptions(int argc, char* argv[], LoadOptions& opt);
+bool parseMix(const string& spec, int* mix);
+bool prepareDataDir(LoadOptions& opt, bool& scratch);
+void removeDataDir(const string& dir);
+bool seedEvent(const LoadOptions& opt);
+
+// Backend process functions
+long long nowMs();
+bool startBackend(const LoadOptions& opt, bool serve, BackendProcess& proc);
+void stopBackend(BackendProcess& proc, bool kill);
+bool writeAll(int fd, const string& data);
+int readLine(BackendProcess& proc, string& line, long long deadlineMs);
+int runOneShot(const LoadOptions& opt, const string& input, string& output);
+int runResident(const LoadOptions& opt, BackendProcess& proc, const string& input, string& output);
+
+// Request functions
+LoadOp opKind(int opCode);
+int countOccurrences(const string& text, const char* needle);
+bool generateRequest(const LoadOptions& opt, int client, unsigned& rng, vector<string>& users, int& counter, LoadRequest& req);
+bool buildInput(const LoadRequest& req, bool framed, string& input);
+void checkResponse(const LoadOptions& opt, const LoadRequest& req, const string& output, vector<string>& users, int& lastPoll, ClientResult& result);
+void runClient(const LoadOptions& opt, int client, const vector<LoadRequest>* replay, ClientResult& result);
+
+// Trace functions
+bool loadTrace(const string& filename, LoadOptions& opt, vector<vector<LoadRequest> >& perClient);
+bool sentEarlier(const LoadRequest& a, const LoadRequest& b);
+bool writeTrace(const string& filename, const LoadOptions& opt, vector<LoadRequest>& trace);
+
+// Report functions
+double percentile(vector<double>& sorted, double p);
+long long checkIntegrity(const LoadOptions& opt, long long failedLogins, long long pollRegressions, long long countMismatches);
+
+// Shared run state
+mutex customerMutex;
+unordered_map<string, int> customerIDs;  // username -> ID, from successful signups
+vector<int> registeredCustomers;         // customers whose registration for the event succeeded
+atomic<int> signupsIssued(0);
+atomic<long long> requestsIssued(0);
+chrono::steady_clock::time_point runStart;
+
+// Main entry point
+int main(int argc, char* argv[]) {
+    LoadOptions opt;
+    if (!parseOptions(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);  // a backend that dies mid-request is reported, not fatal
+
+    vector<vector<LoadRequest> > replay;
+    if (!opt.replayFile.empty() && !loadTrace(opt.replayFile, opt, replay)) {
+        cerr << "Cannot read trace " << opt.replayFile << endl;
+        return 2;
+    }
+
+    bool scratch = false;
+    if (!prepareDataDir(opt, scratch) || !seedEvent(opt)) {
+        cerr << "Cannot set up data directory " << opt.dataDir << endl;
+        return 2;
+    }
+
+    // Every client runs on its own thread with its own backend connection
+    vector<ClientResult> results(opt.clients);
+    vector<thread> threads;
+    runStart = chrono::steady_clock::now();
+    for (int c = 0; c < opt.clients; c++) {
+        const vector<LoadRequest>* clientReplay = replay.empty() ? NULL : &replay[c];
+        threads.push_back(thread(runClient, cref(opt), c, clientReplay, ref(results[c])));
+    }
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - runStart).count();
+
+    // Merge per-client results
+    ClientResult total;
+    vector<LoadRequest> trace;
+    for (int c = 0; c < opt.clients; c++) {
+        for (int k = 0; k < LOAD_OP_COUNT; k++) {
+            total.latencyUs[k].insert(total.latencyUs[k].end(), results[c].latencyUs[k].begin(), results[c].latencyUs[k].end());
+            total.ok[k] += results[c].ok[k];
+            total.rejected[k] += results[c].rejected[k];
+            total.failed[k] += results[c].failed[k];
+            total.timeouts[k] += results[c].timeouts[k];
+        }
+        total.failedLogins += results[c].failedLogins;
+        total.pollRegressions += results[c].pollRegressions;
+        total.countMismatches += results[c].countMismatches;
+        trace.insert(trace.end(), results[c].trace.begin(), results[c].trace.end());
+    }
+
+    long long issued = 0;
+    for (int k = 0; k < LOAD_OP_COUNT; k++) issued += total.ok[k] + total.rejected[k] + total.failed[k] + total.timeouts[k];
+    cout << "Load Test: " << (opt.resident ? "resident" : "one-shot") << " mode, " << opt.clients
+         << " clients, " << issued << " requests" << (opt.replayFile.empty() ? "" : " (replay)") << endl;
+    cout << "Elapsed: " << elapsed << " s Throughput: " << issued / elapsed << " req/s" << endl;
+    for (int k = 0; k < LOAD_OP_COUNT; k++) {
+        vector<double>& lat = total.latencyUs[k];
+        if (lat.empty() && total.failed[k] == 0 && total.timeouts[k] == 0) continue;
+        sort(lat.begin(), lat.end());
+        cout << "Op: " << LOAD_OP_NAMES[k] << " OK: " << total.ok[k] << " Rejected: " << total.rejected[k]
+             << " Failed: " << total.failed[k] << " Timeouts: " << total.timeouts[k]
+             << " p50: " << percentile(lat, 0.50) / 1000 << " ms p95: " << percentile(lat, 0.95) / 1000
+             << " ms p99: " << percentile(lat, 0.99) / 1000 << " ms p99.9: " << percentile(lat, 0.999) / 1000
+             << " ms max: " << (lat.empty() ? 0 : lat.back()) / 1000 << " ms" << endl;
+    }
+    long long violations = checkIntegrity(opt, total.failedLogins, total.pollRegressions, total.countMismatches);
+
+    if (!opt.recordFile.empty() && !writeTrace(opt.recordFile, opt, trace)) {
+        cerr << "Cannot write trace " << opt.recordFile << endl;
+    }
+    if (scratch && !opt.keepData) {
+        removeDataDir(opt.dataDir);
+    } else {
+        cout << "Data: " << opt.dataDir << endl;
+    }
+    return violations > 0 ? 1 : 0;
+}
+
+// Setup function definitions
+void usage() {
+    cerr << "Usage: loadgen [options]\n"
+         << "  --backend PATH      backend executable (default ./backend)\n"
+         << "  --data DIR          data directory to run against (default: a scratch directory)\n"
+         << "  --keep              keep the scratch data directory\n"
+         << "  --resident          one resident backend per client instead of one process per request\n"
+         << "  --clients N         concurrent clients (default " << DEFAULT_CLIENTS << ")\n"
+         << "  --requests N        total requests (default " << DEFAULT_REQUESTS << ")\n"
+         << "  --duration S        run for S seconds instead of a request count\n"
+         << "  --event ID          event everyone registers for (default " << DEFAULT_EVENT_ID << ")\n"
+         << "  --seats N           seats on the event, 0 for unlimited (default " << DEFAULT_SEATS << ")\n"
+         << "  --mix SPEC          weights, e.g. signup=15,login=30,register=40,poll=10,count=5\n"
+         << "  --record FILE       write the requests issued to a trace file\n"
+         << "  --replay FILE       replay a trace instead of generating requests\n"
+         << "  --paced             replay at the recorded times instead of as fast as possible\n";
+}
+
+bool parseOptions(int argc, char* argv[], LoadOptions& opt) {
+    opt.backend = "./backend";
+    opt.resident = opt.keepData = opt.paced = false;
+    opt.clients = DEFAULT_CLIENTS;
+    opt.requests = DEFAULT_REQUESTS;
+    opt.eventID = DEFAULT_EVENT_ID;
+    opt.seats = DEFAULT_SEATS;
+    opt.durationSec = 0;
+    parseMix("signup=15,login=30,register=40,poll=10,count=5", opt.mix);
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--resident") opt.resident = true;
+        else if (arg == "--keep") opt.keepData = true;
+        else if (arg == "--paced") opt.paced = true;
+        else if (!hasValue) return false;
+        else if (arg == "--backend") opt.backend = argv[++i];
+        else if (arg == "--data") opt.dataDir = argv[++i];
+        else if (arg == "--record") opt.recordFile = argv[++i];
+        else if (arg == "--replay") opt.replayFile = argv[++i];
+        else if (arg == "--clients") opt.clients = atoi(argv[++i]);
+        else if (arg == "--requests") opt.requests = atoi(argv[++i]);
+        else if (arg == "--duration") opt.durationSec = atof(argv[++i]);
+        else if (arg == "--event") opt.eventID = atoi(argv[++i]);
+        else if (arg == "--seats") opt.seats = atoi(argv[++i]);
+        else if (arg == "--mix") {
+            if (!parseMix(argv[++i], opt.mix)) return false;
+        }
+        else return false;
+    }
+
+    // The child changes into the data directory, so it needs an absolute backend path
+    char resolved[4096];
+    if (!realpath(opt.backend.c_str(), resolved)) {
+        cerr << "Backend not found: " << opt.backend << endl;
+        return false;
+    }
+    opt.backend = resolved;
+    return opt.clients > 0 && opt.requests >= 0 && opt.seats >= 0;
+}
+
+bool parseMix(const string& spec, int* mix) {
+    // "signup=15,login=30,..."; kinds left out get weight 0
+    for (int k = 0; k < LOAD_OP_COUNT; k++) mix[k] = 0;
+    stringstream parts(spec);
+    string part;
+    int total = 0;
+    while (getline(parts, part, ',')) {
+        size_t eq = part.find('=');
+        if (eq == string::npos) return false;
+        string name = part.substr(0, eq);
+        int k = 0;
+        while (k < LOAD_OP_COUNT && name != LOAD_OP_NAMES[k]) k++;
+        if (k == LOAD_OP_COUNT) return false;
+        mix[k] = atoi(part.c_str() + eq + 1);
+        if (mix[k] < 0) return false;
+        total += mix[k];
+    }
+    return total > 0;
+}
+
+bool prepareDataDir(LoadOptions& opt, bool& scratch) {
+    if (opt.dataDir.empty()) {
+        char dir[] = "/tmp/ems-load-XXXXXX";
+        if (!mkdtemp(dir)) return false;
+        opt.dataDir = dir;
+        scratch = true;
+        return true;
+    }
+    if (mkdir(opt.dataDir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    char resolved[4096];
+    if (!realpath(opt.dataDir.c_str(), resolved)) return false;
+    opt.dataDir = resolved;
+    return true;
+}
+
+void removeDataDir(const string& dir) {
+    // The data directory is flat: remove its files, then the directory
+    DIR* d = opendir(dir.c_str());
+    if (!d) return;
+    struct dirent* entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        remove((dir + "/" + entry->d_name).c_str());
+    }
+    closedir(d);
+    rmdir(dir.c_str());
+}
+
+bool seedEvent(const LoadOptions& opt) {
+    // The event's seat map, then staff and vendors whose counts the organisers' count
+    // requests must keep reporting
+    if (opt.seats > 0) {
+        stringstream input;
+        input << "31\n" << opt.eventID << "\n" << opt.seats << "\n";
+        string output;
+        if (runOneShot(opt, input.str(), output) != 0 || output.find("Seats: ") == string::npos) return false;
+    }
+    for (int i = 0; i < SEED_STAFF; i++) {
+        stringstream input;
+        input << "13\n" << opt.eventID << "\nStaff " << i << "\nstaff" << i << "@load.test\nOps\nCrew\n";
+        string output;
+        if (runOneShot(opt, input.str(), output) != 0 || output.find("added successfully") == string::npos) return false;
+    }
+    for (int i = 0; i < SEED_VENDORS; i++) {
+        stringstream input;
+        input << "16\n" << opt.eventID << "\nVendor " << i << "\nvendor" << i << "@load.test\nFood\n100\n";
+        string output;
+        if (runOneShot(opt, input.str(), output) != 0 || output.find("added successfully") == string::npos) return false;
+    }
+    return true;
+}
+
+// Backend process function definitions
+long long nowMs() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool startBackend(const LoadOptions& opt, bool serve, BackendProcess& proc) {
+    int in[2], out[2];
+    if (pipe(in) != 0) return false;
+    if (pipe(out) != 0) {
+        close(in[0]);
+        close(in[1]);
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(in[0]); close(in[1]); close(out[0]); close(out[1]);
+        return false;
+    }
+    if (pid == 0) {
+        // Child: only async-signal-safe calls until exec
+        dup2(in[0], 0);
+        dup2(out[1], 1);
+        int devNull = open("/dev/null", O_WRONLY);
+        if (devNull >= 0) dup2(devNull, 2);  // the backend's debug output
+        close(in[0]); close(in[1]); close(out[0]); close(out[1]);
+        if (chdir(opt.dataDir.c_str()) != 0) _exit(127);
+        const char* serveArg = serve ? "--serve" : NULL;
+        execl(opt.backend.c_str(), opt.backend.c_str(), serveArg, (char*)NULL);
+        _exit(127);
+    }
+    close(in[0]);
+    close(out[1]);
+    fcntl(in[1], F_SETFD, FD_CLOEXEC);   // keep other clients' children from inheriting our pipes
+    fcntl(out[0], F_SETFD, FD_CLOEXEC);
+    proc.pid = pid;
+    proc.toChild = in[1];
+    proc.fromChild = out[0];
+    proc.pending.clear();
+    return true;
+}
+
+void stopBackend(BackendProcess& proc, bool kill) {
+    if (proc.pid <= 0) return;
+    if (kill) ::kill(proc.pid, SIGKILL);
+    if (proc.toChild >= 0) close(proc.toChild);
+    close(proc.fromChild);
+    int status;
+    waitpid(proc.pid, &status, 0);
+    proc.pid = -1;
+}
+
+bool writeAll(int fd, const string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+int readLine(BackendProcess& proc, string& line, long long deadlineMs) {
+    // 1 with a line, 0 at end of output, -1 on timeout
+    while (true) {
+        size_t nl = proc.pending.find('\n');
+        if (nl != string::npos) {
+            line = proc.pending.substr(0, nl);
+            proc.pending.erase(0, nl + 1);
+            return 1;
+        }
+        long long wait = deadlineMs - nowMs();
+        if (wait <= 0) return -1;
+        pollfd pfd;
+        pfd.fd = proc.fromChild;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int rc = poll(&pfd, 1, (int)wait);
+        if (rc < 0 && errno == EINTR) continue;
+        if (rc == 0) return -1;
+        char buf[4096];
+        ssize_t n = read(proc.fromChild, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            if (proc.pending.empty()) return 0;
+            line = proc.pending;  // last line without a newline
+            proc.pending.clear();
+            return 1;
+        }
+        proc.pending.append(buf, (size_t)n);
+    }
+}
+
+int runOneShot(const LoadOptions& opt, const string& input, string& output) {
+    // One process per request, as the bridge does without a resident backend.
+    // Returns 0 when done, -1 on timeout, 1 if the backend could not be run.
+    BackendProcess proc;
+    if (!startBackend(opt, false, proc)) return 1;
+    writeAll(proc.toChild, input);
+    close(proc.toChild);
+    proc.toChild = -1;
+
+    output.clear();
+    long long deadline = nowMs() + REQUEST_TIMEOUT_MS;
+    string line;
+    int rc;
+    while ((rc = readLine(proc, line, deadline)) == 1) output += line + "\n";
+    stopBackend(proc, rc < 0);
+    return rc < 0 ? -1 : 0;
+}
+
+int runResident(const LoadOptions& opt, BackendProcess& proc, const string& input, string& output) {
+    // Framed request to this client's resident backend; restarted after a timeout or crash
+    if (proc.pid <= 0 && !startBackend(opt, true, proc)) return 1;
+    output.clear();
+    if (!writeAll(proc.toChild, input)) {
+        stopBackend(proc, true);
+        return 1;
+    }
+    long long deadline = nowMs() + REQUEST_TIMEOUT_MS;
+    string line;
+    int rc;
+    while ((rc = readLine(proc, line, deadline)) == 1) {
+        if (line == "END") return 0;
+        output += line + "\n";
+    }
+    stopBackend(proc, true);
+    return rc < 0 ? -1 : 1;
+}
+
+// Request function definitions
+LoadOp opKind(int opCode) {
+    switch (opCode) {
+        case 3: return LOAD_SIGNUP;
+        case 4: return LOAD_LOGIN;
+        case 12: return LOAD_REGISTER;
+        case 10: return LOAD_POLL;
+        case 21: case 22: return LOAD_COUNT;
+    }
+    return LOAD_OP_COUNT;
+}
+
+bool generateRequest(const LoadOptions& opt, int client, unsigned& rng, vector<string>& users, int& counter, LoadRequest& req) {
+    // Pick the next request by the mix weights; requests needing a customer fall back to a
+    // signup until this client has one
+    int total = 0;
+    for (int k = 0; k < LOAD_OP_COUNT; k++) total += opt.mix[k];
+    rng = rng * 1103515245 + 12345;
+    int pick = (int)((rng >> 8) % (unsigned)total);
+    int kind = 0;
+    while (pick >= opt.mix[kind]) pick -= opt.mix[kind++];
+
+    if ((kind == LOAD_LOGIN || kind == LOAD_REGISTER) && users.empty()) kind = LOAD_SIGNUP;
+    if (kind == LOAD_SIGNUP && signupsIssued++ >= MAX_CUSTOMERS) kind = users.empty() ? LOAD_POLL : LOAD_LOGIN;
+
+    counter++;
+    req.client = client;
+    req.fields.clear();
+    stringstream eventID;
+    eventID << opt.eventID;
+    rng = rng * 1103515245 + 12345;
+    unsigned r = rng >> 8;
+
+    switch (kind) {
+        case LOAD_SIGNUP: {
+            stringstream user;
+            user << "c" << client << "_" << counter;
+            req.opCode = 3;
+            // Some customers are named "END", which must not end a resident request early
+            req.fields.push_back(counter % 8 == 0 ? "END" : "Customer " + user.str());
+            req.fields.push_back(user.str() + "@load.test");
+            req.fields.push_back(user.str());
+            req.fields.push_back("pw");
+            break;
+        }
+        case LOAD_LOGIN: {
+            // One login in five is for an unknown user
+            req.opCode = 4;
+            if (r % 5 == 0) {
+                stringstream user;
+                user << "nobody" << client << "_" << counter;
+                req.fields.push_back(user.str());
+            } else {
+                req.fields.push_back(users[r % users.size()]);
+            }
+            req.fields.push_back("pw");
+            break;
+        }
+        case LOAD_REGISTER: {
+            // Any of this client's customers, so repeat registrations happen too. With a seat
+            // map the backend assigns the ticket; an unlimited event keeps a caller-chosen one.
+            stringstream ticket;
+            ticket << (opt.seats > 0 ? 0 : 10000 + r % 90000);
+            req.opCode = 12;
+            req.fields.push_back("@" + users[r % users.size()]);
+            req.fields.push_back(eventID.str());
+            req.fields.push_back(ticket.str());
+            req.fields.push_back("Unpaid");
+            break;
+        }
+        case LOAD_POLL:
+            req.opCode = 10;
+            req.fields.push_back(eventID.str());
+            break;
+        default:
+            req.opCode = r % 2 ? 21 : 22;
+            req.fields.push_back(eventID.str());
+            break;
+    }
+    return true;
+}
+
+bool buildInput(const LoadRequest& req, bool framed, string& input) {
+    // Backend input lines, resolving "@username" customer IDs; false if the customer is unknown
+    stringstream out;
+    out << req.opCode << "\n";
+    for (size_t i = 0; i < req.fields.size(); i++) {
+        const string& field = req.fields[i];
+        if (field.size() > 1 && field[0] == '@') {
+            lock_guard<mutex> guard(customerMutex);
+            unordered_map<string, int>::iterator it = customerIDs.find(field.substr(1));
+            if (it == customerIDs.end()) return false;
+            out << it->second << "\n";
+        } else {
+            out << field << "\n";
+        }
+    }
+    input = out.str();
+    if (framed) {
+        // Resident requests are prefixed with their length in bytes
+        stringstream length;
+        length << input.size() << "\n";
+        input = length.str() + input;
+    }
+    return true;
+}
+
+int countOccurrences(const string& text, const char* needle) {
+    int count = 0;
+    for (size_t pos = text.find(needle); pos != string::npos; pos = text.find(needle, pos + 1)) count++;
+    return count;
+}
+
+void checkResponse(const LoadOptions& opt, const LoadRequest& req, const string& output, vector<string>& users, int& lastPoll, ClientResult& result) {
+    LoadOp kind = opKind(req.opCode);
+    switch (kind) {
+        case LOAD_SIGNUP: {
+            size_t pos = output.find("Your ID: ");
+            if (output.find("registered successfully") == string::npos || pos == string::npos) {
+                result.failed[kind]++;
+                return;
+            }
+            int id = atoi(output.c_str() + pos + 9);
+            {
+                lock_guard<mutex> guard(customerMutex);
+                customerIDs[req.fields[2]] = id;
+            }
+            users.push_back(req.fields[2]);
+            result.ok[kind]++;
+            return;
+        }
+        case LOAD_LOGIN:
+            if (output.find("LOGIN SUCCESS") != string::npos) {
+                result.ok[kind]++;
+            } else if (output.find("Invalid credentials") != string::npos) {
+                // Expected for unknown users; for a customer whose signup succeeded it's a lost write
+                lock_guard<mutex> guard(customerMutex);
+                if (customerIDs.count(req.fields[0])) {
+                    result.failedLogins++;
+                    result.failed[kind]++;
+                } else {
+                    result.rejected[kind]++;
+                }
+            } else {
+                result.failed[kind]++;
+            }
+            return;
+        case LOAD_REGISTER:
+            if (output.find("added successfully") != string::npos) {
+                lock_guard<mutex> guard(customerMutex);
+                registeredCustomers.push_back(customerIDs[req.fields[0].substr(1)]);
+                result.ok[kind]++;
+            } else if (output.find("Already Registered") != string::npos || output.find("Sold Out") != string::npos) {
+                result.rejected[kind]++;
+            } else {
+                result.failed[kind]++;
+            }
+            return;
+        case LOAD_POLL: {
+            // Registrations are only ever added, so a client's polls must never shrink
+            int rows = countOccurrences(output, "CustID: ");
+            if (rows == 0 && output.find("No registrations found") == string::npos) {
+                result.failed[kind]++;
+                return;
+            }
+            if (rows < lastPoll) result.pollRegressions++;
+            lastPoll = rows;
+            result.ok[kind]++;
+            return;
+        }
+        case LOAD_COUNT: {
+            const char* label = req.opCode == 21 ? "Staff Count: " : "Vendor Count: ";
+            size_t pos = output.find(label);
+            if (pos == string::npos) {
+                result.failed[kind]++;
+                return;
+            }
+            int expected = req.opCode == 21 ? SEED_STAFF : SEED_VENDORS;
+            if (req.fields[0] == to_string(opt.eventID) && atoi(output.c_str() + pos + strlen(label)) != expected) {
+                result.countMismatches++;
+            }
+            result.ok[kind]++;
+            return;
+        }
+        default:
+            return;
+    }
+}
+
+void runClient(const LoadOptions& opt, int client, const vector<LoadRequest>* replay, ClientResult& result) {
+    BackendProcess proc;
+    proc.pid = -1;
+    vector<string> users;
+    int counter = 0, lastPoll = 0;
+    unsigned rng = 2166136261u ^ (unsigned)(client * 16777619);
+    size_t replayNext = 0;
+    long long deadlineUs = (long long)(opt.durationSec * 1e6);
+
+    while (true) {
+        LoadRequest req;
+        long long sinceStart = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - runStart).count();
+        if (replay) {
+            if (replayNext == replay->size()) break;
+            req = (*replay)[replayNext++];
+            if (opt.paced && req.atUs > sinceStart) {
+                this_thread::sleep_for(chrono::microseconds(req.atUs - sinceStart));
+            }
+            requestsIssued++;
+        } else {
+            if (deadlineUs > 0 ? sinceStart >= deadlineUs : requestsIssued++ >= opt.requests) break;
+            if (deadlineUs > 0) requestsIssued++;
+            generateRequest(opt, client, rng, users, counter, req);
+        }
+
+        LoadOp kind = opKind(req.opCode);
+        if (kind == LOAD_OP_COUNT) continue;  // not an op this tool checks
+        string input, output;
+        if (!buildInput(req, opt.resident, input)) {
+            result.failed[kind]++;  // its customer's signup failed
+            continue;
+        }
+
+        chrono::steady_clock::time_point sent = chrono::steady_clock::now();
+        req.atUs = chrono::duration_cast<chrono::microseconds>(sent - runStart).count();
+        int rc = opt.resident ? runResident(opt, proc, input, output) : runOneShot(opt, input, output);
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - sent).count();
+        if (!opt.recordFile.empty()) result.trace.push_back(req);
+
+        if (rc < 0) {
+            result.timeouts[kind]++;
+            continue;
+        }
+        if (rc > 0) {
+            result.failed[kind]++;
+            continue;
+        }
+        result.latencyUs[kind].push_back(us);
+        checkResponse(opt, req, output, users, lastPoll, result);
+    }
+
+    if (proc.pid > 0) {
+        close(proc.toChild);  // the resident backend exits at end of input
+        proc.toChild = -1;
+        stopBackend(proc, false);
+    }
+}
+
+// Trace function definitions
+// A trace is a "# ems-trace event <ID> seats <N> clients <N>" header, then one request per line:
+// send time (microseconds), client, op code and input lines, separated by tabs.
+
+bool loadTrace(const string& filename, LoadOptions& opt, vector<vector<LoadRequest> >& perClient) {
+    ifstream file(filename.c_str());
+    if (!file) return false;
+    string line;
+    if (!getline(file, line)) return false;
+    int clients = 0;
+    if (sscanf(line.c_str(), "# ems-trace event %d seats %d clients %d", &opt.eventID, &opt.seats, &clients) != 3) return false;
+    opt.clients = clients > 0 ? clients : 1;
+    perClient.assign(opt.clients, vector<LoadRequest>());
+
+    while (getline(file, line)) {
+        if (line.empty()) continue;
+        stringstream parts(line);
+        string field;
+        LoadRequest req;
+        if (!getline(parts, field, '\t')) continue;
+        req.atUs = atoll(field.c_str());
+        if (!getline(parts, field, '\t')) continue;
+        req.client = atoi(field.c_str());
+        if (!getline(parts, field, '\t')) continue;
+        req.opCode = atoi(field.c_str());
+        while (getline(parts, field, '\t')) req.fields.push_back(field);
+        if (req.client < 0 || req.client >= opt.clients) return false;
+        perClient[req.client].push_back(req);
+    }
+    return true;
+}
+
+bool sentEarlier(const LoadRequest& a, const LoadRequest& b) {
+    return a.atUs < b.atUs;
+}
+
+bool writeTrace(const string& filename, const LoadOptions& opt, vector<LoadRequest>& trace) {
+    // Registrations are recorded against "@username", so the trace replays on fresh data
+    ofstream file(filename.c_str());
+    if (!file) return false;
+    sort(trace.begin(), trace.end(), sentEarlier);
+    file << "# ems-trace event " << opt.eventID << " seats " << opt.seats << " clients " << opt.clients << "\n";
+    for (size_t i = 0; i < trace.size(); i++) {
+        file << trace[i].atUs << "\t" << trace[i].client << "\t" << trace[i].opCode;
+        for (size_t f = 0; f < trace[i].fields.size(); f++) file << "\t" << trace[i].fields[f];
+        file << "\n";
+    }
+    return (bool)file;
+}
+
+// Report function definitions
+double percentile(vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = (size_t)(p * sorted.size());
+    return sorted[index < sorted.size() ? index : sorted.size() - 1];
+}
+
+long long checkIntegrity(const LoadOptions& opt, long long failedLogins, long long pollRegressions, long long countMismatches) {
+    // Compare what clients were told succeeded with what the data files hold, via the query op
+    string output;
+    unordered_map<int, int> idCount;
+    unordered_map<string, int> stored;  // username -> ID in customers.dat
+    runOneShot(opt, "28\ncustomers\n0\nID,username\n0\n", output);
+    stringstream customers(output);
+    string line;
+    while (getline(customers, line)) {
+        int id;
+        char username[32];
+        if (sscanf(line.c_str(), "ID: %d username: %31s", &id, username) != 2) continue;
+        idCount[id]++;
+        stored[username] = id;
+    }
+    long long duplicateIDs = 0;
+    for (unordered_map<int, int>::iterator it = idCount.begin(); it != idCount.end(); ++it) {
+        if (it->second > 1) duplicateIDs += it->second - 1;
+    }
+    long long lostSignups = 0;
+    for (unordered_map<string, int>::iterator it = customerIDs.begin(); it != customerIDs.end(); ++it) {
+        unordered_map<string, int>::iterator found = stored.find(it->first);
+        if (found == stored.end() || found->second != it->second) lostSignups++;
+    }
+
+    stringstream query;
+    query << "28\nregistrations\n1\neventID = " << opt.eventID << "\ncustomerID,ticketNum\n0\n";
+    runOneShot(opt, query.str(), output);
+    stringstream regs(output);
+    unordered_map<int, int> regCount, ticketCount;
+    long long registrations = 0;
+    while (getline(regs, line)) {
+        int custID, ticket;
+        if (sscanf(line.c_str(), "customerID: %d ticketNum: %d", &custID, &ticket) != 2) continue;
+        regCount[custID]++;
+        ticketCount[ticket]++;
+        registrations++;
+    }
+    long long duplicateRegs = 0, lostRegs = 0, duplicateTickets = 0;
+    for (unordered_map<int, int>::iterator it = regCount.begin(); it != regCount.end(); ++it) {
+        if (it->second > 1) duplicateRegs += it->second - 1;
+    }
+    if (opt.seats > 0) {
+        // Seat-mapped tickets are seat numbers, so each one must be held at most once
+        for (unordered_map<int, int>::iterator it = ticketCount.begin(); it != ticketCount.end(); ++it) {
+            if (it->second > 1) duplicateTickets += it->second - 1;
+        }
+    }
+    for (size_t i = 0; i < registeredCustomers.size(); i++) {
+        if (!regCount.count(registeredCustomers[i])) lostRegs++;
+    }
+    long long oversold = opt.seats > 0 && registrations > opt.seats ? registrations - opt.seats : 0;
+
+    cout << "Customers: " << stored.size() << " Duplicate IDs: " << duplicateIDs << " Lost Signups: " << lostSignups
+         << " Failed Logins: " << failedLogins << endl;
+    cout << "Registrations: " << registrations << " Seats: " << opt.seats << " Oversold: " << oversold
+         << " Duplicate Registrations: " << duplicateRegs << " Lost Registrations: " << lostRegs
+         << " Duplicate Tickets: " << duplicateTickets << endl;
+    cout << "Poll Regressions: " << pollRegressions << " Count Mismatches: " << countMismatches << endl;
+    long long violations = duplicateIDs + lostSignups + failedLogins + oversold + duplicateRegs + lostRegs + duplicateTickets +
+                           pollRegressions + countMismatches;
+    cout << "Integrity Violations: " << violations << endl;
+    return violations;
+}
@@ -37,6 +37,8 @@ ipcMain.handle('customer:signup', async (event, data) => backend.customerSignup(
 ipcMain.handle('customer:login', async (event, username, password) => backend.customerLogin(username, password));
 ipcMain.handle('customer:register', async (event, data) => backend.customerRegister(data));
 ipcMain.handle('customer:getRegistrations', async (event, custID) => backend.customerGetRegistrations(custID));
+ipcMain.handle('customer:bookGroup', async (event, data) => backend.customerBookGroup(data));
+ipcMain.handle('customer:cancelRegistration', async (event, data) => backend.customerCancelRegistration(data));
 
 // ======================= EVENT IPC =======================
 ipcMain.handle('event:add', async (event, data) => backend.addEvent(data));
@@ -59,6 +61,7 @@ ipcMain.handle('vendor:update', async (event, data) => backend.vendorUpdate(data
 // ======================= REGISTRATION IPC =======================
 ipcMain.handle('registration:getByEvent', async (event, eventID) => backend.registrationGetByEvent(eventID));
 ipcMain.handle('registration:updateFeeStatus', async (event, data) => backend.updateCustomerFeeStatus(data));
+ipcMain.handle('event:exportRoster', async (event, data) => backend.exportRoster(data));
 
 // ======================= COUNTING IPC (RECURSIVE) =======================
 ipcMain.handle('event:getStaffCount', async (event, eventID) => backend.getStaffCountByEvent(eventID));
@@ -16,6 +16,8 @@ const api = {
     customerLogin: (username, password) => ipcRenderer.invoke('customer:login', username, password),
     customerRegister: (data) => ipcRenderer.invoke('customer:register', data),
     customerGetRegistrations: (custID) => ipcRenderer.invoke('customer:getRegistrations', custID),
+    customerBookGroup: (data) => ipcRenderer.invoke('customer:bookGroup', data),
+    customerCancelRegistration: (data) => ipcRenderer.invoke('customer:cancelRegistration', data),
     
     // Staff
     staffAdd: (data) => ipcRenderer.invoke('staff:add', data),
@@ -32,6 +34,7 @@ const api = {
     // Registration
     registrationGetByEvent: (eventID) => ipcRenderer.invoke('registration:getByEvent', eventID),
     updateCustomerFeeStatus: (data) => ipcRenderer.invoke('registration:updateFeeStatus', data),
+    exportRoster: (data) => ipcRenderer.invoke('event:exportRoster', data),
     
     // Counting (Recursive)
     getStaffCountByEvent: (eventID) => ipcRenderer.invoke('event:getStaffCount', eventID),